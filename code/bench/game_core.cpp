@@ -0,0 +1,145 @@
+/*
+  Steps the game core (include/GameCore.h) on the host, without the shim's pins or
+  virtual clock: a player inserts a 2 euro coin whenever the balance is below the
+  stake and presses the trigger between rounds, and once more to quick stop every third
+  round while its reels spin. The core is stepped every ms of game time with the
+  simulator's turbo timing. Prints the steps and rounds per second of
+  CPU time.
+
+  pio run -e native_game_core && .pio/build/native_game_core/program
+
+  Plays the rounds twice and exits with 1 if the runs differ in any frame or event,
+  if the balance or the ledger's cash in, bets and wins do not match the coins, stakes
+  and payouts, or if a round did not end exactly spinDuration() after it started.
+*/
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Config.h"
+#include "GameCore.h"
+
+const unsigned long rounds = 20000;
+const uint16_t coin = 200;
+
+// the simulator's turbo timing, the global config stays untouched
+static Config settings;
+
+struct Run {
+  unsigned long steps;
+  long coins, stakes, payouts;
+  unsigned long lateRounds;
+  uint32_t hash;          // of every frame and event
+  long balance;
+  CreditLedger ledger;
+  double seconds;
+};
+
+static void fold(uint32_t &hash, const uint8_t *data, size_t size) {
+  // FNV-1a
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 16777619UL;
+  }
+}
+
+static Run play() {
+  GameCore *game = new GameCore(settings);
+  Run run;
+  memset(&run, 0, sizeof(run));
+  run.hash = 2166136261UL;
+  unsigned long played = 0;
+  unsigned long now = 1;
+  unsigned long roundStart = 0;
+  bool stopPressed = false;
+  GameInputs inputs = {true, false, 0};   // the first press switches the machine on
+
+  clock_t start = clock();
+  while (played < rounds) {
+    const GameOutput &out = game->step(now, inputs);
+    run.steps++;
+    inputs.trigger = false;
+    inputs.coin = 0;
+
+    if (out.events & GAME_COIN) {
+      run.coins += out.coin;
+    }
+    if (out.events & GAME_ROUND_OPENED) {
+      run.stakes += GameCore::spinCost;
+      roundStart = now;
+      stopPressed = false;
+    }
+    if (out.events & GAME_ROUND_OVER) {
+      run.payouts += out.payout;
+      if (now - roundStart != game->spinDuration()) {
+        run.lateRounds++;
+      }
+      played++;
+    }
+    if (out.reelsChanged) {
+      fold(run.hash, &out.reels[0][0], sizeof(out.reels));
+    }
+    if (out.balanceChanged) {
+      fold(run.hash, out.balance, sizeof(out.balance));
+    }
+    fold(run.hash, &out.events, 1);
+
+    if (game->acceptsCoins()) {
+      if (game->balance() < GameCore::spinCost) {
+        inputs.coin = coin;
+      } else {
+        inputs.trigger = true;
+      }
+    } else if (played % 3 == 2 && !stopPressed && game->state() == SPINNING) {
+      inputs.trigger = true;
+      stopPressed = true;
+    }
+    now++;
+  }
+  run.seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  run.balance = game->balance();
+  run.ledger = game->ledger();
+  delete game;
+  return run;
+}
+
+void setup() {
+  settings.reset();
+  settings.set("frameTime", 10);
+  settings.set("spinTime", 0);
+  settings.set("waitBeforeIdle", 0);
+  settings.set("blinkTime", 10);
+  settings.set("startSpeed", 60);
+  settings.set("minSpeed", 80);
+
+  Run first = play();
+  Run second = play();
+
+  printf("%lu rounds, %lu steps in %.2f s CPU: %.0f steps/s, %.0f rounds/s\n", rounds, first.steps,
+         first.seconds, first.steps / first.seconds, rounds / first.seconds);
+  printf("coins %.2f  stakes %.2f  payouts %.2f  balance %.2f\n", first.coins / 100.0,
+         first.stakes / 100.0, first.payouts / 100.0, first.balance / 100.0);
+
+  const CreditLedger &counted = first.ledger;
+  bool ledger = first.balance == first.coins - first.stakes + first.payouts &&
+                counted.cashIn == (uint32_t)first.coins && counted.bet == (uint32_t)first.stakes &&
+                counted.won == (uint32_t)first.payouts;
+  bool same = first.hash == second.hash && first.steps == second.steps;
+  if (!ledger) {
+    printf("balance does not match the ledger\n");
+  }
+  if (!same) {
+    printf("the second run differs\n");
+  }
+  if (first.lateRounds != 0) {
+    printf("%lu rounds did not take spinDuration()\n", first.lateRounds);
+  }
+  bool ok = ledger && same && first.lateRounds == 0;
+  printf("%s\n", ok ? "OK" : "FAILED");
+  fflush(stdout);
+  exit(ok ? 0 : 1);
+}
+
+void loop() {
+}
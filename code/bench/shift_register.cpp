@@ -0,0 +1,71 @@
+/*
+  Time one reel frame takes through shiftOut() against ShiftRegisterChain::write()
+  (lib/FastGPIO/src/FastGPIO.h).
+
+  Runs on the cabinet (or any Uno, the register chain on the pins of Wiring.h is
+  optional) and prints the cycles and us each way takes for the registerCount bytes
+  of a frame. The reel dimmer does not run, and each frame goes out with interrupts
+  off, so neither Timer0 nor anything else lands in the numbers.
+
+  pio run -e bench_shift_register -t upload && pio device monitor
+*/
+
+#include <Arduino.h>
+#include "CycleClock.h"
+#include "FastGPIO.h"
+#include "Wiring.h"
+
+const uint8_t runs = 100;
+
+typedef ShiftRegisterChain<dataPin, clockPin, latchPin> Registers;
+
+uint8_t frame[registerCount];
+
+static void arduinoWrite(const uint8_t *data, uint8_t length) {
+  digitalWrite(latchPin, LOW);
+  for (uint8_t i = 0; i < length; i++) {
+    shiftOut(dataPin, clockPin, LSBFIRST, data[i]);
+  }
+  digitalWrite(latchPin, HIGH);
+}
+
+static void fastWrite(const uint8_t *data, uint8_t length) {
+  Registers::write(data, length);
+}
+
+static void measure(const __FlashStringHelper *name, void (*write)(const uint8_t *, uint8_t)) {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < runs; i++) {
+    // a different frame every run, like the reels while they spin
+    for (uint8_t j = 0; j < registerCount; j++) {
+      frame[j] = i + j;
+    }
+    noInterrupts();
+    uint32_t start = CycleClock::now();
+    write(frame, registerCount);
+    total += CycleClock::now() - start;
+    interrupts();
+  }
+  Serial.print(name);
+  Serial.print(total / runs);
+  Serial.print(F(" cycles, "));
+  Serial.print(CycleClock::toMicros(total / runs));
+  Serial.println(F(" us"));
+}
+
+void setup() {
+  Serial.begin(115200);
+  CycleClock::begin();
+  Registers::begin();
+  pinMode(outputEnablePin, OUTPUT);
+  digitalWrite(outputEnablePin, LOW);
+
+  Serial.print(registerCount);
+  Serial.println(F(" byte frame"));
+  measure(F("shiftOut()\t"), arduinoWrite);
+  measure(F("ShiftRegisterChain::write()\t"), fastWrite);
+  Registers::fill(0, registerCount);
+}
+
+void loop() {
+}
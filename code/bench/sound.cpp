@@ -0,0 +1,59 @@
+/*
+  Interrupt budget of the sound synthesizer (include/Sound.h).
+
+  Runs on the cabinet (or any Uno, speaker on A0 optional) and prints the cycles one
+  sample takes without the interrupt entry and exit, and the share of the CPU the
+  whole interrupt takes while the win jingle plays: a busy loop counts how far it
+  gets in a while with and without sound.
+
+  pio run -e bench_sound -t upload && pio device monitor
+*/
+
+#include <Arduino.h>
+#include "Config.h"
+#include "CycleClock.h"
+#include "Sound.h"
+
+const uint8_t samples = 100;
+const unsigned long window = 200;    // ms per busy loop count
+
+static unsigned long countLoops() {
+  volatile unsigned long loops = 0;
+  unsigned long start = millis();
+  while (millis() - start < window) {
+    loops++;
+  }
+  return loops;
+}
+
+void setup() {
+  Serial.begin(115200);
+  config.reset();
+  CycleClock::begin();
+  sound.begin();
+
+  // the interrupt stays off, the samples are called directly
+  sound.play(SOUND_WIN);
+  TIMSK1 &= ~_BV(OCIE1B);
+  noInterrupts();
+  uint32_t start = CycleClock::now();
+  for (uint8_t i = 0; i < samples; i++) {
+    sound.sample();
+  }
+  uint32_t cycles = CycleClock::now() - start;
+  interrupts();
+  Serial.print(F("sample: "));
+  Serial.print(cycles / samples);
+  Serial.print(F(" cycles of "));
+  Serial.println(Sound::samplePeriod);
+
+  unsigned long silent = countLoops();
+  sound.play(SOUND_WIN);
+  unsigned long playing = countLoops();
+  Serial.print(F("CPU while playing: "));
+  Serial.print(100.0 * (silent - playing) / silent, 1);
+  Serial.println(F(" %"));
+}
+
+void loop() {
+}
@@ -0,0 +1,67 @@
+/*
+  Bus time of SevenSegmentTM1637 against the lite TM1637<Clk, Dio> driver.
+
+  Runs on the cabinet (balance display on pins 13/12) and prints the average time of
+  the calls the game makes. For flash and static RAM compare the size reports of
+  `pio run -e uno` (lite driver) and `pio run -e uno_full_display`.
+*/
+
+#include <Arduino.h>
+#include "SevenSegmentTM1637.h"
+#include "SevenSegmentTM1637Lite.h"
+
+const uint8_t clockPin = 13;
+const uint8_t dataPin = 12;
+const uint8_t runs = 100;
+
+const uint8_t digits[4] = {TM1637_CHAR_1, TM1637_CHAR_2, TM1637_CHAR_3, TM1637_CHAR_4};
+
+template<class Display>
+void measure(const __FlashStringHelper *name, Display &display) {
+  unsigned long start;
+
+  Serial.print(name);
+
+  start = micros();
+  for (uint8_t i = 0; i < runs; i++) {
+    display.printRaw(digits, 4, 0);
+  }
+  Serial.print(F("\t4 digits "));
+  Serial.print((micros() - start) / runs);
+
+  start = micros();
+  for (uint8_t i = 0; i < runs; i++) {
+    display.printRaw(digits[0], 3);
+  }
+  Serial.print(F(" us\t1 digit "));
+  Serial.print((micros() - start) / runs);
+
+  start = micros();
+  for (uint8_t i = 0; i < runs; i++) {
+    display.setBacklight(100);
+  }
+  Serial.print(F(" us\tbrightness "));
+  Serial.print((micros() - start) / runs);
+  Serial.println(F(" us"));
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  SevenSegmentTM1637 full(clockPin, dataPin);
+  full.begin();
+  TM1637<clockPin, dataPin> lite;
+  lite.begin();
+
+  Serial.print(F("RAM per instance: full "));
+  Serial.print(sizeof(full));
+  Serial.print(F(" bytes, lite "));
+  Serial.print(sizeof(lite));
+  Serial.println(F(" bytes"));
+
+  measure(F("full"), full);
+  measure(F("lite"), lite);
+}
+
+void loop() {
+}
@@ -0,0 +1,131 @@
+/*
+  Bus protocol of SevenSegmentTM1637 and the lite TM1637<Clk, Dio> driver against the
+  TM1637 model of the simulator (sim/Tm1637Model.h), on the host under virtual time.
+
+  For every half clock period from TM1637_CLK_DELAY_US down to 0 both drivers write
+  four digits and the brightness, the full driver also reads a key code. A period
+  passes when the model saw no timing violation and holds exactly the bytes that were
+  sent. Prints one line per driver and period, then the period tm1637Calibrate() picks.
+
+  pio run -e native_tm1637_protocol && .pio/build/native_tm1637_protocol/program
+
+  Exit code 1 if a clean transfer came out wrong, if a driver does not pass at
+  TM1637_CLK_DELAY_US or if the calibration picks a period that did not pass.
+*/
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ArduinoNative.h"
+#include "SevenSegmentTM1637.h"
+#include "SevenSegmentTM1637Lite.h"
+#include "TM1637Calibration.h"
+#include "Tm1637Model.h"
+
+const uint8_t clockPin = 13;
+const uint8_t dataPin = 12;
+const uint8_t keyCode = 0xF5;
+
+const uint8_t digits[4] = {TM1637_CHAR_1, TM1637_CHAR_2, TM1637_CHAR_3, TM1637_CHAR_4};
+
+static Tm1637Model chip(clockPin, dataPin);
+static bool failed = false;
+
+static void onPin(uint8_t pin, uint8_t level, uint64_t micros) {
+  chip.onPin(pin, level, micros);
+}
+
+static uint8_t readKeys(SevenSegmentTM1637 &display) {
+  return display.comReadByte();
+}
+
+template<uint8_t Clk, uint8_t Dio>
+static uint8_t readKeys(TM1637<Clk, Dio> &) {
+  return keyCode;   // the lite driver only writes
+}
+
+// Fastest period that passed, with every slower one passing too; -1 if none
+template<class Display>
+int8_t sweep(const __FlashStringHelper *name, Display &display) {
+  int8_t fastest = TM1637_CLK_DELAY_US + 1;
+  for (int8_t period = TM1637_CLK_DELAY_US; period >= 0; period--) {
+    TM1637Bus::halfPeriod = period;
+    uint8_t sent[4];
+    for (uint8_t i = 0; i < 4; i++) {
+      sent[i] = digits[(i + period) % 4];
+    }
+    unsigned long violations = chip.violations();
+    unsigned long bytes = chip.bytes();
+    chip.setKeys(keyCode);
+
+    display.printRaw(sent, 4, 0);
+    display.setBacklight(100);
+    uint8_t keys = readKeys(display);
+
+    bool clean = chip.violations() == violations;
+    bool same = keys == keyCode && chip.isOn() && chip.brightness() == 8;
+    for (uint8_t i = 0; i < 4; i++) {
+      same &= chip.digit(i) == sent[i];
+    }
+
+    Serial.print(name);
+    Serial.print(F("\t"));
+    Serial.print(period);
+    Serial.print(F(" us\t"));
+    Serial.print(chip.bytes() - bytes);
+    Serial.print(F(" bytes\t"));
+    Serial.print(chip.violations() - violations);
+    Serial.print(F(" violations\t"));
+    Serial.println(!clean ? F("violated") : same ? F("ok") : F("WRONG"));
+
+    if (clean && !same) {
+      failed = true;
+    }
+    if (clean && same && fastest == period + 1) {
+      fastest = period;
+    }
+  }
+  if (fastest > TM1637_CLK_DELAY_US) {
+    failed = true;
+    return -1;
+  }
+  return fastest;
+}
+
+void setup() {
+  nativeAddPinListener(onPin);
+
+  SevenSegmentTM1637 full(clockPin, dataPin);
+  full.begin();
+  int8_t fullFastest = sweep(F("full"), full);
+
+  TM1637<clockPin, dataPin> lite;
+  TM1637Bus::halfPeriod = TM1637_CLK_DELAY_US;
+  lite.begin();
+  int8_t liteFastest = sweep(F("lite"), lite);
+
+  bool calibrated = tm1637Calibrate(full);
+  Serial.print(F("calibrated "));
+  Serial.print(TM1637Bus::halfPeriod);
+  Serial.println(F(" us"));
+  int8_t fastest = fullFastest > liteFastest ? fullFastest : liteFastest;
+  if (!calibrated || fastest < 0 || TM1637Bus::halfPeriod < fastest) {
+    failed = true;
+  }
+
+  Serial.print(F("display: "));
+  Serial.print(chip.transactions());
+  Serial.print(F(" transactions, "));
+  Serial.print(chip.errors());
+  Serial.println(F(" errors"));
+  chip.report(stdout);
+  fflush(stdout);
+  if (chip.errors() != 0) {
+    failed = true;
+  }
+  Serial.println(failed ? F("FAILED") : F("OK"));
+  exit(failed ? 1 : 0);
+}
+
+void loop() {
+}
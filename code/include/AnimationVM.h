@@ -0,0 +1,88 @@
+#ifndef ANIMATION_VM_H
+#define ANIMATION_VM_H
+
+#include <Arduino.h>
+#include "ReelGeometry.h"
+
+/*
+Interpreter for the attract animations of the reels. A program is a byte string in
+PROGMEM that draws into frame[row][reel] (segment bits as in GameCore.cpp) and shows it
+with WAIT. step() runs the program up to its next WAIT and returns how long that
+frame stays, so the program advances one frame per tick of the caller's timer.
+
+Operands that name digits are cells: row in the high nibble, reel in the low one,
+ANIM_ALL (0xF) in either means every row or every reel, ANIM_CELL(ANIM_ALL, ANIM_ALL)
+the whole frame. Cells outside the layout are ignored, so a program written for 3x3
+also runs on 5x3.
+
+  ANIM_END                      program is over
+  ANIM_SET     cell value       digits show value
+  ANIM_SETR    cell reg         digits show register reg
+  ANIM_LD      reg value        register = value
+  ANIM_ADD     reg value        register += value (wraps)
+  ANIM_XOR     reg value        register ^= value, toggles segments
+  ANIM_ROT     cell steps       outer segments turn clockwise by steps (6 is a full turn)
+  ANIM_SHIFTR  steps            rows move down by steps, the bottom ones come in at the top
+  ANIM_SHIFTC  steps            reels move right by steps, wrapping the same way
+  ANIM_MIRROR  axis             ANIM_MIRROR_REELS (left/right) or ANIM_MIRROR_ROWS (top/bottom),
+                                the segments of every digit are mirrored too
+  ANIM_LOOP    count            repeats up to the matching ANIM_NEXT count times, 0 forever
+  ANIM_NEXT
+  ANIM_WAIT    time             shows the frame for time * 10 ms
+
+Loops nest ANIMATION_LOOP_DEPTH deep, a LOOP deeper than that ends the program like
+an unknown opcode does. A step that runs ANIMATION_MAX_OPS instructions without
+reaching a WAIT shows the frame anyway, so a broken program cannot stall the loop.
+*/
+
+#define ANIM_END      0x00
+#define ANIM_SET      0x01
+#define ANIM_SETR     0x02
+#define ANIM_LD       0x03
+#define ANIM_ADD      0x04
+#define ANIM_ROT      0x05
+#define ANIM_SHIFTR   0x06
+#define ANIM_SHIFTC   0x07
+#define ANIM_MIRROR   0x08
+#define ANIM_LOOP     0x09
+#define ANIM_NEXT     0x0A
+#define ANIM_WAIT     0x0B
+#define ANIM_XOR      0x0C
+
+#define ANIM_ALL            0x0F
+#define ANIM_CELL(row, reel) (((row) << 4) | (reel))
+#define ANIM_MIRROR_REELS   1
+#define ANIM_MIRROR_ROWS    2
+
+#define ANIMATION_REGISTERS   4
+#define ANIMATION_LOOP_DEPTH  2
+#define ANIMATION_MAX_OPS     64
+
+class AnimationVM {
+public:
+  // Starts program (in PROGMEM) on a dark frame
+  void        start(const uint8_t *program);
+  // Runs up to the next WAIT, returns how long the frame stays in ms, 0 once the program ended
+  uint16_t    step();
+  bool        finished() const { return _program == NULL; }
+
+  // [row][reel], what the program drew so far
+  byte        frame[Geometry::rows][Geometry::reels];
+
+private:
+  uint8_t     fetch() { return pgm_read_byte(_program + _pc++); }
+  void        set(uint8_t cell, byte value);
+  void        rotate(uint8_t cell, uint8_t steps);
+  void        shiftRows(uint8_t steps);
+  void        shiftReels(uint8_t steps);
+  void        mirror(uint8_t axis);
+
+  const uint8_t *_program;
+  uint16_t    _pc;
+  uint8_t     _registers[ANIMATION_REGISTERS];
+  uint16_t    _loopStart[ANIMATION_LOOP_DEPTH];
+  uint8_t     _loopCount[ANIMATION_LOOP_DEPTH];
+  uint8_t     _loops;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef COIN_ACCEPTOR_H
+#define COIN_ACCEPTOR_H
+
+#include <Arduino.h>
+
+/*
+Counts the coins of a pulse output coin validator on coinPulsePin (ICP1). The
+validator pulls the line low once per config.coinPulseValue cents, so a train of
+pulses is one coin; the train ends once no pulse followed for config.coinTrainGap ms.
+
+The input capture interrupt of Timer1 only timestamps the edges with CycleClock (the
+timer keeps running free) and puts them into a ring. poll() measures the pulses and
+gaps from these timestamps, so how late the main loop gets to them changes nothing,
+as long as the ring holds the edges in between: COIN_EDGE_BUFFER edges are 8 pulses,
+two coins of 2 euros. Edges that do not fit are counted as dropped.
+
+Pulses shorter than config.coinPulseMin are noise and ignored, one longer than
+config.coinPulseMax rejects its coin, and so does a train that adds up to no coin
+value. Accepted coins are counted per value until take() hands them out.
+
+On the host poll() samples the pin instead, once per loop.
+*/
+
+#define COIN_EDGE_BUFFER  16    // power of two
+#define COIN_VALUE_COUNT  3
+
+class CoinAcceptor {
+public:
+  void        begin();
+  // Decodes the edges captured since the last call, call every loop
+  void        poll();
+  // Hands out the next counted coin, false if there is none
+  bool        take(uint16_t &cents);
+
+  // Edges the ring had no room for and trains that were no coin, since begin()
+  uint16_t    dropped() const;
+  uint16_t    rejected() const { return _rejected; }
+
+  // Called from TIMER1_CAPT_vect with the cycle count of the edge and the level after it
+  void        capture(uint32_t time, uint8_t level);
+
+private:
+  void        edge(uint32_t time, uint8_t level);
+  void        endTrain();
+
+  // edge times, bit 0 holds the level after the edge
+  volatile uint32_t _edges[COIN_EDGE_BUFFER];
+  volatile uint8_t  _head;        // written by capture()
+  volatile uint8_t  _tail;        // written by poll()
+  volatile uint16_t _dropped;
+  uint8_t     _level;             // last edge decoded
+  bool        _train;             // a coin is coming in
+  bool        _invalid;           // its train had a pulse too long
+  uint8_t     _pulses;
+  uint32_t    _pulseStart;
+  uint32_t    _pulseEnd;          // of the last pulse counted
+  uint16_t    _rejected;
+  uint8_t     _counted[COIN_VALUE_COUNT];
+};
+
+extern CoinAcceptor coinAcceptor;
+// Coins the machine takes in cents, counted in this order
+extern const uint16_t coinValues[COIN_VALUE_COUNT];
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <Arduino.h>
+#include "EepromLayout.h"
+
+/*
+Timing and feel parameters of the machine, changeable at runtime.
+
+save() writes them to EEPROM as a versioned block with a CRC:
+  'C' version size  Config[size]  crc16 (little endian)
+load() only accepts a block of the current version and size, anything else
+leaves the defaults in place. Bump CONFIG_VERSION when the fields change.
+*/
+
+#define CONFIG_VERSION 7
+
+class Config {
+public:
+  // The reels speed up and slow down about as fast as changing their speed by a random
+  // accell (see below) every frameTime would
+  uint16_t frameTime;
+  // Time after a spin to wait before resuming idle animation
+  uint16_t waitBeforeIdle;
+  // Time the reels spin at top speed
+  uint16_t spinTime;
+  // ms per reel step at full speed, at rest and when the result starts scrolling in
+  uint16_t topSpeed;
+  uint16_t minSpeed;
+  uint16_t startSpeed;
+  // Range of the random ms per frame a reel speeds up and slows down by
+  uint16_t minRandomAccell;
+  uint16_t maxRandomAccell;
+  // Time a winning line is on or off while blinking
+  uint16_t blinkTime;
+  // Half clock period of the balance display bus in us, 0 calibrates it at boot
+  uint16_t busDelay;
+  // Reel digit brightness (0..15) during a game and while idle
+  uint16_t reelBrightness;
+  uint16_t idleBrightness;
+  // Coin validator pulses (ms): shorter ones are noise, longer ones reject the coin,
+  // a coin ends after coinTrainGap without a pulse; every pulse is worth coinPulseValue cents
+  uint16_t coinPulseMin;
+  uint16_t coinPulseMax;
+  uint16_t coinTrainGap;
+  uint16_t coinPulseValue;
+  // Trigger presses during a round that each buy one more round, 0 ignores them; with
+  // quickStopTime set the first press of a spinning round quick stops it instead
+  uint16_t spinQueue;
+  // Pause between rounds that follow each other without a press
+  uint16_t roundPause;
+  // Rounds an autoplay run plays (holding the trigger starts one, 0 never), and their spinTime
+  uint16_t autoplayRounds;
+  uint16_t autoplaySpinTime;
+  // The first press while the reels speed up or spin stops them one after another within
+  // this time, 0 never (every press queues then)
+  uint16_t quickStopTime;
+  // Sound effects on (1) or off (0)
+  uint16_t sound;
+
+  void        reset();
+  // Loads the saved block, returns false (and keeps the current values) if there is none
+  bool        load();
+  void        save() const;
+
+  // Access by name for the console, set() refuses values that break the spin physics
+  bool        get(const char *name, uint16_t &value) const;
+  bool        set(const char *name, uint16_t value);
+  uint8_t     count() const;
+  // Copies the name of parameter index into buffer (PROGMEM on the board)
+  void        name(uint8_t index, char *buffer, uint8_t size) const;
+
+private:
+  int         find(const char *name) const;
+  bool        isConsistent() const;
+  uint16_t   *field(uint8_t index);
+  uint16_t    crc() const;
+};
+
+extern Config config;
+
+#endif
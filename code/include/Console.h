@@ -0,0 +1,43 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <Arduino.h>
+
+/*
+Line based command reader for the serial port.
+
+poll() only consumes what has already arrived, it never waits for the rest of a
+line. Once a line ends (CR or LF) it is split into whitespace separated words and
+poll() returns true; the words stay valid until the next call. Lines longer than
+CONSOLE_LINE_LENGTH are dropped as a whole.
+*/
+
+#define CONSOLE_LINE_LENGTH 32
+#define CONSOLE_MAX_ARGS    4
+
+class Console {
+public:
+  void        begin(Stream &port);
+  // Reads the available input, returns true when a complete command is ready
+  bool        poll();
+
+  uint8_t     argc() const { return _argc; }
+  const char *argv(uint8_t index) const { return index < _argc ? _argv[index] : ""; }
+  // Parses argument index as a number, returns false if it is not one
+  bool        number(uint8_t index, long &value) const;
+  // True if the previous line was too long and had to be dropped
+  bool        overflowed() const { return _overflow; }
+
+private:
+  void        split();
+
+  Stream     *_port;
+  char        _line[CONSOLE_LINE_LENGTH + 1];
+  uint8_t     _length;
+  bool        _overflow;
+  bool        _discarding;
+  uint8_t     _argc;
+  const char *_argv[CONSOLE_MAX_ARGS];
+};
+
+#endif
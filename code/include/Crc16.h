@@ -0,0 +1,18 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), bitwise so it needs no table in flash.
+// Start with crc16Init and feed every byte through crc16Update.
+const uint16_t crc16Init = 0xFFFF;
+
+inline uint16_t crc16Update(uint16_t crc, uint8_t data) {
+  crc ^= (uint16_t)data << 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef CYCLE_CLOCK_H
+#define CYCLE_CLOCK_H
+
+#include <Arduino.h>
+
+/*
+CPU cycle counter: Timer1 runs free at the full clock (normal mode, no prescaler)
+and its overflow interrupt extends it to 32 bits, so now() wraps after 268 s at
+16 MHz. Differences of two readings are exact to the cycle plus the few cycles the
+reading takes. The overflow interrupt costs about 2 us every 4 ms.
+
+Timer1 PWM (analogWrite() on pins 9 and 10) is gone once begin() ran, its input
+capture unit (see CoinAcceptor.h) and compare unit B (see Sound.h) stay free. On
+the host the count follows micros().
+*/
+
+#ifdef F_CPU
+  #define CYCLES_PER_MICROSECOND (F_CPU / 1000000UL)
+#else
+  #define CYCLES_PER_MICROSECOND 16UL
+#endif
+
+class CycleClock {
+public:
+  static void     begin();
+  // Cycles since begin(), callable with interrupts disabled
+  static uint32_t now();
+  static uint32_t toMicros(uint32_t cycles) { return cycles / CYCLES_PER_MICROSECOND; }
+#ifdef __AVR__
+  // Extends a Timer1 count latched moments ago (ICR1) to a now() reading, interrupts disabled
+  static uint32_t fromCapture(uint16_t count);
+#endif
+
+  // Called from TIMER1_OVF_vect
+  static void     overflow() { _overflows++; }
+
+private:
+  static volatile uint16_t _overflows;
+};
+
+#endif
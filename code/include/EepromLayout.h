@@ -0,0 +1,14 @@
+#ifndef EEPROM_LAYOUT_H
+#define EEPROM_LAYOUT_H
+
+// Everything persisted in the 1 KB EEPROM of the ATmega328, by byte offset.
+// Keep the blocks from overlapping when adding a new one.
+
+// Round journal: ring of RoundJournal records (8 bytes each)
+#define EEPROM_JOURNAL_START    0
+#define EEPROM_JOURNAL_RECORDS  64
+
+// Runtime configuration block, see Config.h
+#define EEPROM_CONFIG_START     512
+
+#endif
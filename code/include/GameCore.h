@@ -0,0 +1,190 @@
+#ifndef GAME_CORE_H
+#define GAME_CORE_H
+
+#include <Arduino.h>
+#include "AnimationVM.h"
+#include "ReelGeometry.h"
+#include "Timers.h"
+
+class Config;
+
+/*
+The game without the hardware: state machine, credits, outcome, reel motion, the
+attract animation and the blinking of wins and of the balance. step() moves it to
+now with the inputs since the last step and returns what the reels and the balance
+display show and what happened. It never touches a pin, the clock, the serial port
+or the EEPROM, so the same inputs at the same times always give the same frames.
+Its settings come from the Config it was made with, read on every step, so a change
+takes effect at the next one.
+The outcome comes from its own copy of the avr-libc generator behind random(). The
+adapter seeds it once with noise, every round mixes its start time into the state,
+so neither the seed nor the timing of the rounds alone decides the outcomes.
+
+main.cpp is the adapter: it makes the core with the config the console edits,
+debounces the buttons, takes the coins from the validator, calls step() once per loop,
+sends changed frames to the displays and turns the events into journal records and
+telemetry. bench/game_core.cpp steps it on the host alone, with a config of its own.
+
+Steps come at least every few ms while the reels spin; a late step catches up on the
+reel phases it missed, the balance counts by 5 cents per step.
+*/
+
+// the numbers are part of the telemetry and the journal
+enum State { OFF, IDLE, START_SPINNING, SPINUP, SPINNING, SPINDOWN, WAITING };
+enum WinType { HTOP, HMID, HBOT, DTL, DTR, NONE };
+
+// Events of a step, bits of GameOutput::events
+#define GAME_COIN           0x01  // coin credited, GameOutput::coin
+#define GAME_ROUND_OPENED   0x02  // stake taken and outcome drawn (outcome(), winCells(), accel())
+#define GAME_ROUND_OVER     0x04  // GameOutput::payout paid
+#define GAME_REEL_STEP      0x08  // the reel that stops last moved on by a symbol
+#define GAME_REEL_STOPPED   0x10  // a reel came to rest
+
+// Money since boot in cents. Only the main loop touches it (the interrupt counts presses
+// and coins for the adapter, see main.cpp), so 32 bits cannot tear; they also last for
+// any session, where an int stopped at 327.67 euros.
+struct CreditLedger {
+  uint32_t cashIn;        // coins inserted
+  uint32_t bet;           // stakes of the rounds played
+  uint32_t won;           // payouts, recovered rounds included
+  int32_t  displayLag;    // change the balance display has yet to count through
+
+  int32_t  balance() const { return (int32_t)(cashIn + won - bet); }
+};
+
+struct GameInputs {
+  bool     trigger;       // debounced press since the last step
+  bool     triggerDown;   // trigger held down now
+  uint16_t coin;          // cents inserted since the last step, 0 for none
+};
+
+struct GameOutput {
+  // reel digits [row][reel] (segment bits, see GameCore.cpp), new if reelsChanged
+  uint8_t  reels[Geometry::rows][Geometry::reels];
+  bool     reelsChanged;
+  // balance display digits left to right (TM1637 segments), new if balanceChanged
+  uint8_t  balance[4];
+  bool     balanceChanged;
+  bool     balanceOn;     // off while the balance blinks
+  uint8_t  events;
+  uint16_t coin;
+  uint16_t payout;
+};
+
+class GameCore {
+public:
+  // Price of one round in cents
+  static const int spinCost = 100;
+  // Holding the trigger this long (ms) when a round starts turns autoplay on
+  static const unsigned long autoplayHold = 1500;
+
+  static int  payoutFor(WinType type);
+
+  explicit GameCore(const Config &config);
+  const GameOutput &step(unsigned long now, const GameInputs &inputs);
+
+  // Seeds the outcome generator, once at boot with whatever noise the hardware has
+  void        seed(uint32_t entropy);
+  // Pays a round out of turn, like one recovered from the journal
+  void        payRecovered(uint16_t payout);
+
+  State       state() const { return _state; }
+  const CreditLedger &ledger() const { return _ledger; }
+  int32_t     balance() const { return _ledger.balance(); }
+  // Coins count between rounds only, the validator keeps the others until then
+  bool        acceptsCoins() const { return _state == IDLE || _state == WAITING; }
+
+  // Outcome of the current or last round
+  WinType     outcome() const { return _wintype; }
+  uint16_t    winCells() const;
+  const unsigned long *accel() const { return _accel; }
+  // ms from the start of the spin until the last reel is at rest, quick stop included
+  unsigned long spinDuration() const { return _spinDuration; }
+
+private:
+  // Deadlines of the core (see Timers.h)
+  enum TimerId {
+    IDLE_FRAME_TIMER,   // next idle animation frame
+    STAGE_TIMER,        // end of WAITING
+    BLINK_TIMER,        // next on/off of the blinking balance
+    HOLD_TIMER,         // trigger held long enough for autoplay
+    REEL_TIMER,         // next scroll phase of reel 0, the other reels follow
+    TIMER_COUNT = REEL_TIMER + Geometry::reels
+  };
+
+  // Motion of a reel over the whole spin, planned when it starts (see planSpin()).
+  // Phases count scroll phases from the start: the reel speeds up until upEnd, spins at
+  // full speed until cruiseEnd, slows down until downEnd and lands until stopPhase, the
+  // last rows symbol steps scrolling its result in from the top.
+  struct ReelMotion {
+    uint16_t phase;
+    uint16_t upEnd;
+    uint16_t cruiseEnd;
+    uint16_t downEnd;
+    uint16_t stopPhase;
+    uint16_t cruiseDelay;   // ms per phase at full speed
+  };
+
+  void        press(unsigned long now);
+  void        insert(uint16_t coin);
+  void        checkTriggerHold(unsigned long now, bool down);
+  bool        takeQueuedRound();
+  void        startSpinning(unsigned long now);
+  void        drawOutcome();
+  uint16_t    rampPhases(uint16_t from, uint16_t to, unsigned long accel) const;
+  uint16_t    phaseDelay(const ReelMotion &reel) const;
+  void        planSpin(unsigned long spinTime, unsigned long now);
+  void        quickStop(unsigned long now);
+  void        finishRound(unsigned long now);
+  void        nextAnimationFrame(unsigned long now);
+  void        nextIdleAnimationFrame(unsigned long now);
+  void        blinkWin(unsigned long now);
+  void        animateBalanceBlink(unsigned long now);
+  void        showReels(const uint8_t frame[Geometry::rows][Geometry::reels]);
+  void        showBalance(const uint8_t digits[4]);
+  void        renderBalance();
+  void        mix(unsigned long now);
+  long        random(long howbig);
+  long        random(long howsmall, long howbig);
+
+  const Config &_config;
+  GameOutput  _out;
+  bool        _reelsValid;      // _out.reels was shown, false until the first frame
+  State       _state;
+  Timers<TIMER_COUNT> _timers;
+  AnimationVM _attract;
+  uint8_t     _currentIdleAnimation;
+
+  // Money belonging to the human, the display counts displayLag towards 0
+  CreditLedger _ledger;
+  // on/off changes of the balance display left to blink
+  uint8_t     _blinkBalance;
+
+  // Rounds to play after this one: trigger presses during a round (up to spinQueue)
+  // and the rest of an autoplay run (autoplayRounds). Any press stops autoplay.
+  uint8_t     _queuedSpins;
+  uint8_t     _autoplayRounds;
+  // The press that started this round may still be held down (see checkTriggerHold())
+  bool        _triggerHeld;
+
+  WinType     _wintype;
+  // final symbols, [reel][row]
+  uint8_t     _result[Geometry::reels][Geometry::rows];
+  unsigned long _accel[Geometry::reels];
+  ReelMotion  _motion[Geometry::reels];
+  // ms per symbol step at rest, at full speed and where the landing starts, as the spin started
+  uint16_t    _restSpeed;
+  uint16_t    _fullSpeed;
+  uint16_t    _landingSpeed;
+  // ms the spin started at and takes until the last reel is at rest
+  unsigned long _spinStart;
+  unsigned long _spinDuration;
+  // reel planned to come to rest last, its symbol steps are the GAME_REEL_STEP ticks
+  uint8_t     _tickReel;
+
+  uint32_t    _random;          // state of the outcome generator
+};
+
+extern GameCore game;
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef LOOP_GUARD_H
+#define LOOP_GUARD_H
+
+#include <Arduino.h>
+
+/*
+Watches the main loop so a stall ends in a reset instead of a frozen machine.
+
+The AVR watchdog resets the board when one loop() iteration takes longer than the
+budget the sketch set for its current state (arm()). Every iteration and every
+timed interrupt handler is measured in CPU cycles (see CycleClock.h), the longest
+of each go into a record in .noinit RAM together with the state of the last
+iteration. A reset does not clear that section, so after the next boot previous()
+tells how the last run ended and why the board reset:
+  resetFlags  MCUSR bits: 0x01 power on, 0x02 reset button, 0x04 brown out, 0x08 watchdog
+After a power on or brown out the RAM holds garbage and previous() is not valid.
+
+On the host there is no watchdog, the cycles follow micros().
+*/
+
+// Reset flags, as in MCUSR
+#define LOOP_GUARD_POWER_ON     0x01
+#define LOOP_GUARD_RESET_BUTTON 0x02
+#define LOOP_GUARD_BROWN_OUT    0x04
+#define LOOP_GUARD_WATCHDOG     0x08
+
+struct LoopGuardRecord {
+  uint16_t magic;
+  uint8_t  state;               // of the last loop() iteration
+  uint8_t  budget;              // watchdog timeout index it ran with
+  uint8_t  maxLoopState;        // state of the longest iteration
+  uint32_t maxLoopCycles;
+  uint32_t maxInterruptCycles;
+};
+
+class LoopGuard {
+public:
+  // Takes over the record of the last run and starts a new one, call early in setup()
+  void        begin();
+  // Record of the run before this boot, false if there is none
+  bool        hasPrevious() const { return _hasPrevious; }
+  const LoopGuardRecord &previous() const { return _previous; }
+  // MCUSR of this boot
+  uint8_t     resetFlags() const;
+
+  // Starts the watchdog or changes its timeout, budget in ms (rounded up to 15..8000)
+  void        arm(uint16_t budget);
+  // Call first in every loop() iteration: resets the watchdog, measures the iteration
+  void        loopStarted(uint8_t state);
+  // Call at the end of an interrupt handler with the CycleClock::now() of its start
+  void        interruptDone(uint32_t start);
+
+  uint32_t    maxLoopCycles() const;
+  uint32_t    maxInterruptCycles() const;
+
+private:
+  LoopGuardRecord _previous;
+  bool        _hasPrevious;
+  uint32_t    _loopStart;
+};
+
+extern LoopGuard loopGuard;
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef MEMORY_WATCH_H
+#define MEMORY_WATCH_H
+
+#include <Arduino.h>
+
+/*
+SRAM headroom of the ATmega328 (2 KB): static data, heap and stack.
+
+At reset, before the C runtime runs, all RAM between the end of the static data
+(.data, .bss, .noinit) and the top of the stack is painted with a canary byte. The
+stack overwrites the canaries as it grows, so the lowest overwritten byte marks the
+deepest it has ever been. The heap grows up from the static data; sample() keeps
+its highest end.
+
+  | static data | heap -> |    never touched    | <- stack |
+  RAMSTART      _end    heapEnd                        RAMEND
+
+The post-build check in tools/ram_budget.py adds the worst case stack it derives from
+the disassembly to the static data and fails the build when that exceeds
+custom_ram_budget. stackHighWater() should always stay below that figure.
+
+On the host every figure is 0.
+*/
+
+#define MEMORY_CANARY 0xC5
+
+class MemoryWatch {
+public:
+  // Follows the heap, call every loop
+  static void     sample();
+
+  // Bytes of .data, .bss and .noinit
+  static uint16_t staticBytes();
+  // Largest the heap has been
+  static uint16_t heapHighWater();
+  // Deepest the stack has been, counted from RAMEND
+  static uint16_t stackHighWater();
+  // Bytes neither the heap nor the stack ever used
+  static uint16_t untouched();
+  // Bytes between the heap and the stack right now
+  static uint16_t freeNow();
+
+private:
+  static uint16_t _heapHighWater;
+};
+
+#endif
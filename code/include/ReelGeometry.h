@@ -0,0 +1,51 @@
+#ifndef REEL_GEOMETRY_H
+#define REEL_GEOMETRY_H
+
+#include <Arduino.h>
+
+/*
+Layout of the reels: ReelCount reels showing RowCount digits each, one 74HC595
+per digit. The layout is fixed at compile time (-D REEL_COUNT=5), so every table
+and loop over reels, rows or registers has a constant size the compiler can unroll.
+
+Winning lines for any layout:
+  HTOP, HMID, HBOT   top, middle and bottom row
+  DTL                starts top left and bounces between top and bottom row,
+                     a diagonal on 3x3 and a V on 5x3
+  DTR                the same mirrored upside down
+*/
+
+#ifndef REEL_COUNT
+#define REEL_COUNT 3
+#endif
+#ifndef ROW_COUNT
+#define ROW_COUNT 3
+#endif
+
+template<uint8_t ReelCount, uint8_t RowCount>
+struct ReelGeometry {
+  static_assert(ReelCount >= 1 && RowCount >= 1, "at least one reel and row");
+  // winning cells travel as a 16 bit mask in the telemetry
+  static_assert(ReelCount * RowCount <= 16, "at most 16 digits");
+
+  static const uint8_t reels = ReelCount;
+  static const uint8_t rows = RowCount;
+  static const uint8_t cells = ReelCount * RowCount;
+  static const uint8_t registers = cells;
+
+  // Row of the DTL line on a reel
+  static constexpr uint8_t diagonalRow(uint8_t reel) {
+    return RowCount < 2 ? 0 :
+           reel % (2 * (RowCount - 1)) < RowCount ? reel % (2 * (RowCount - 1)) :
+           2 * (RowCount - 1) - reel % (2 * (RowCount - 1));
+  }
+
+  // Bit of a cell in the winning cells mask, reel by reel from the top left
+  static constexpr uint8_t cellBit(uint8_t row, uint8_t reel) {
+    return reel * RowCount + row;
+  }
+};
+
+typedef ReelGeometry<REEL_COUNT, ROW_COUNT> Geometry;
+
+#endif
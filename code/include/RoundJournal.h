@@ -0,0 +1,60 @@
+#ifndef ROUND_JOURNAL_H
+#define ROUND_JOURNAL_H
+
+#include <Arduino.h>
+#include "EepromLayout.h"
+
+/*
+Write-ahead journal of played rounds, kept as a ring of packed records in EEPROM.
+
+A round is opened (outcome and stake written) before the reels start and settled
+(payout written) once they stop. The status byte is always written last, so it acts
+as the commit marker: a record torn by a power loss is either still EMPTY or still
+OPEN, never SETTLED with half of its fields.
+
+Dump frame, sent oldest record first:
+  'J' 'R' version count  record[count]  crc16 (little endian, over everything before it)
+*/
+
+#define JOURNAL_VERSION 1
+
+// Values of JournalRecord::status
+#define JOURNAL_EMPTY     0xFF  // erased EEPROM or a record that was being rewritten
+#define JOURNAL_OPEN      0x5A  // outcome and stake committed, reels not settled yet
+#define JOURNAL_SETTLED   0xA5  // payout committed on GAME_ROUND_OVER (stepGame() in main.cpp)
+#define JOURNAL_RECOVERED 0xC3  // was still open at boot and settled by resolvePendingRound()
+
+struct JournalRecord {
+  uint16_t sequence;  // round number, wraps at 65535
+  uint16_t stake;     // cents
+  uint16_t payout;    // cents, only meaningful once settled
+  uint8_t  outcome;   // WinType drawn by GameCore::step() (GAME_ROUND_OPENED)
+  uint8_t  status;    // commit marker, see JOURNAL_*
+} __attribute__((packed));
+
+class RoundJournal {
+public:
+  // Scans the ring for the newest record, call once in setup()
+  void     begin();
+  // Copies the newest record if it was never settled, returns false otherwise
+  bool     pendingRound(JournalRecord &record) const;
+  // Commits outcome and stake of a new round, call before the reels start
+  void     openRound(uint8_t outcome, uint16_t stake);
+  // Commits the payout of the open round
+  void     settleRound(uint16_t payout, uint8_t status = JOURNAL_SETTLED);
+  // Writes up to count of the newest records as one frame, returns the number sent
+  uint8_t  dump(Print &out, uint8_t count = EEPROM_JOURNAL_RECORDS) const;
+  // Number of valid records in the ring
+  uint8_t  size() const;
+
+private:
+  static int  address(uint8_t slot);
+  static void read(uint8_t slot, JournalRecord &record);
+  static bool isValid(const JournalRecord &record);
+
+  uint8_t   _head;      // slot of the newest record
+  uint8_t   _size;      // valid records in the ring
+  uint16_t  _sequence;  // sequence number of the newest record
+};
+
+#endif
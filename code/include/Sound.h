@@ -0,0 +1,67 @@
+#ifndef SOUND_H
+#define SOUND_H
+
+#include <Arduino.h>
+
+/*
+Sound effects on soundPin, a piezo or a small speaker behind a resistor.
+
+A sound is a sequence of notes in flash, two bytes each: pitch and length. play()
+only points the synthesizer at it and returns, the rest happens in the compare B
+interrupt of Timer1 every samplePeriod cycles (10 kHz): a 16 bit phase accumulator
+advances by the step of the pitch and its top bit is the pin level, a square wave
+within half a sample period of the pitch. When a note runs out the interrupt loads
+the next one, after the last one it switches itself off, so nothing runs while the
+machine is silent.
+
+Why Timer1 and not Timer2: Timer2 belongs to the reel dimmer (ShiftRegisterDimmer.h),
+its TOP changes with every brightness plane, so a compare B interrupt on it would
+not come at a steady rate. Timer1 runs free for CycleClock, OCR1B advanced by a
+fixed step gives an exact sample clock. None of the timers has a PWM pin left (they
+drive the reel chain or read buttons), so the interrupt sets the pin itself.
+
+Budget: about 120 cycles (7.5 us) per sample with entry and exit, under 8% of the
+CPU while a sound plays. The interrupt enables interrupts first thing (ISR_NOBLOCK),
+so the dimmer interrupt and the coin capture never wait for it beyond a few cycles;
+they only delay a sample a little. bench/sound.cpp measures both numbers on the board.
+
+A sound only cuts off one that is less important (the order of SoundId), the tick
+of a spinning reel never cuts a win short. On the host the machine is silent.
+*/
+
+enum SoundId {
+  SOUND_TICK,         // a reel moved by a symbol
+  SOUND_COIN,
+  SOUND_REEL_STOP,
+  SOUND_WIN,
+  SOUND_COUNT
+};
+
+class Sound {
+public:
+  // Sample period in Timer1 cycles and the length unit of the notes in samples (4 ms)
+  static const uint16_t samplePeriod = 1600;
+  static const uint8_t  samplesPerUnit = 40;
+
+  void        begin();
+  // Starts a sound, unless a more important one is playing or config.sound is off
+  void        play(SoundId id);
+  bool        playing() const { return _busy; }
+
+  // Called from TIMER1_COMPB_vect, moves on by one sample
+  void        sample();
+
+private:
+  void        nextNote();
+
+  const uint8_t *volatile _note;    // next note in flash
+  volatile uint16_t _phase;
+  volatile uint16_t _step;          // phase per sample, 0 for a rest
+  volatile uint16_t _left;          // samples left of the current note
+  volatile bool     _busy;          // cleared by the interrupt after the last note
+  SoundId     _playing;
+};
+
+extern Sound sound;
+
+#endif
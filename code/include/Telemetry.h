@@ -0,0 +1,73 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+/*
+Binary telemetry over the serial port.
+
+Every packet is COBS encoded and terminated by a 0x00 byte, so a decoder can
+resynchronise on any zero it sees. Decoded packet layout (little endian):
+  type  sequence  millis[4]  payload[0..TELEMETRY_MAX_PAYLOAD]  crc16[2]
+The CRC-16/CCITT-FALSE covers everything before it.
+
+Packets are queued and handed to the UART only as far as its TX buffer has room,
+so send() and poll() never block. A packet that does not fit in the queue is
+dropped and counted, the count is part of the next profile packet.
+
+Console replies are plain text between packets, also terminated by 0x00.
+*/
+
+#define TELEMETRY_VERSION       4
+#define TELEMETRY_BAUD          115200
+#define TELEMETRY_QUEUE_SIZE    96      // bytes, holds a few encoded packets
+#define TELEMETRY_MAX_PAYLOAD   16
+
+// Packet types
+#define TELEMETRY_BOOT          0x01  // version, reels, rows
+#define TELEMETRY_STATE         0x02  // state
+#define TELEMETRY_OUTCOME       0x03  // wintype, winning cells (bit per digit, reel by reel), accel[2] per reel (at most 0xFFFF)
+#define TELEMETRY_COIN          0x04  // value, balance[4]
+#define TELEMETRY_ROUND_OVER    0x05  // payout, balance[4]
+#define TELEMETRY_PROFILE       0x06  // loops, max loop us, dropped packets
+#define TELEMETRY_RESET         0x07  // reset flags, last state, longest loop state and cycles[4], longest interrupt cycles[4]
+
+class Telemetry {
+public:
+  void    begin(HardwareSerial &port);
+  // Queues a packet, returns false if it was dropped
+  bool    send(uint8_t type, const uint8_t *payload, uint8_t length);
+  // Moves queued bytes to the UART as far as its buffer has room, call every loop
+  void    poll();
+  // Blocks until the queue is empty, for output that bypasses the queue
+  void    flush();
+  // A disabled channel drops every packet, e.g. while someone uses the console
+  void    setEnabled(bool enabled);
+  bool    isEnabled() const;
+
+  void    sendBoot(uint8_t reels, uint8_t rows);
+  void    sendState(uint8_t state);
+  void    sendOutcome(uint8_t wintype, uint16_t winCells, const unsigned long *accel, uint8_t reels);
+  void    sendCoin(uint16_t value, int32_t balance);
+  void    sendRoundOver(uint16_t payout, int32_t balance);
+  void    sendProfile(uint16_t loops, uint16_t maxLoopMicros);
+  // How the run before this boot ended (see LoopGuard.h), state 0xFF if unknown
+  void    sendReset(uint8_t flags, uint8_t state, uint8_t maxLoopState, uint32_t maxLoopCycles,
+                    uint32_t maxInterruptCycles);
+
+private:
+  void    push(uint8_t value);
+  uint8_t freeSpace() const;
+
+  HardwareSerial *_port;
+  uint8_t   _queue[TELEMETRY_QUEUE_SIZE];
+  uint8_t   _head;      // next byte to write
+  uint8_t   _tail;      // next byte to send
+  uint8_t   _sequence;
+  uint8_t   _dropped;   // packets dropped since the last profile packet
+  bool      _enabled;
+};
+
+extern Telemetry telemetry;
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include <Arduino.h>
+
+/*
+A fixed set of named deadlines, one slot per timer id (an enum of the sketch), so
+starting, stopping and checking a timer is O(1) and no subsystem shares another's.
+
+Deadlines are compared relative to now as a signed difference, so they keep working
+when millis() wraps after 49.7 days, as long as no delay is longer than 24.8 days.
+A timer found expired stops, so a deadline that passed long ago never looks like a
+future one after the next wrap. That takes a check at least every 24.8 days: a timer
+nobody looks at for longer seems to expire in the future again. A timer that never
+started counts as expired.
+
+Timers belong to the main loop, which polls its running ones all the time, so nothing
+here is volatile. An interrupt that only runs on an edge keeps the time of its last
+event and compares the unsigned difference instead (see handleButtons() in main.cpp).
+*/
+
+template<uint8_t Capacity>
+class Timers {
+public:
+  Timers() {
+    for (uint8_t i = 0; i < Capacity; i++) {
+      _running[i] = false;
+    }
+  }
+
+  // Expires delay ms after now
+  void start(uint8_t id, unsigned long delay, unsigned long now = millis()) {
+    _deadline[id] = now + delay;
+    _running[id] = true;
+  }
+
+  // Expires delay ms after the deadline it last had, so a chain of delays keeps its
+  // planned times however late each expiry was noticed
+  void advance(uint8_t id, unsigned long delay) {
+    _deadline[id] += delay;
+    _running[id] = true;
+  }
+
+  void stop(uint8_t id) {
+    _running[id] = false;
+  }
+
+  bool isRunning(uint8_t id) const {
+    return _running[id];
+  }
+
+  // True once the delay has passed, or if the timer is not running
+  bool expired(uint8_t id, unsigned long now = millis()) {
+    if (_running[id] && (long)(now - _deadline[id]) >= 0) {
+      _running[id] = false;
+    }
+    return !_running[id];
+  }
+
+  // ms until the timer expires, 0 if it has
+  unsigned long remaining(uint8_t id, unsigned long now = millis()) {
+    return expired(id, now) ? 0 : _deadline[id] - now;
+  }
+
+private:
+  unsigned long _deadline[Capacity];
+  bool          _running[Capacity];
+};
+
+#endif
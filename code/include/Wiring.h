@@ -0,0 +1,63 @@
+#ifndef WIRING_H
+#define WIRING_H
+
+#include <Arduino.h>
+#include "ReelGeometry.h"
+
+// Pins and display wiring of the cabinet, shared by the firmware and the simulator (sim/)
+
+// Serial data out to shift registers
+const int dataPin = 9;
+// Latch to update the current value of the registers
+const int latchPin = 10;
+// Clock for serial data to shift registers
+const int clockPin = 11;
+// Number of chained shift registers, one per reel digit (see ReelGeometry.h)
+const int registerCount = Geometry::registers;
+// Output enable (/OE) of all shift registers, modulated for the reel brightness
+const int outputEnablePin = 7;
+
+// Interrupt for buttons
+const int interruptPin = 2;
+// Input to start game
+const int triggerPin = 6;
+// Input to add 50 cents to the balance
+const int fivetyCentPin = 5;
+// Input to add one euro to the balance
+const int oneEuroPin = 4;
+// Input to add two euros to the balance
+const int twoEurosPin = 3;
+// Pulse output of the coin validator, the input capture pin of Timer1 (ICP1)
+const int coinPulsePin = 8;
+
+// Sound output (A0) to a piezo or a speaker behind a resistor, see Sound.h
+const int soundPin = 14;
+
+// Analog input left open (A1), its noise seeds the outcome generator
+const int noisePin = 15;
+
+// 4 block 7-segment display clock
+const int balanceClock = 13;
+// 4 block 7-segment display data
+const int balanceData = 12;
+
+// Register in the chain for the digit in [row][reel], the first one is furthest from the Arduino
+#if REEL_COUNT == 3 && ROW_COUNT == 3
+const byte segmentOrder[3][3] = {
+  {8, 5, 0},
+  {7, 4, 1},
+  {6, 3, 2}
+};
+#elif REEL_COUNT == 5 && ROW_COUNT == 3
+// wired down each reel, starting with the rightmost
+// UNVERIFIED: extrapolated from the 3x3 chain, never checked on a five reel cabinet
+const byte segmentOrder[3][5] = {
+  {12, 9, 6, 3, 0},
+  {13, 10, 7, 4, 1},
+  {14, 11, 8, 5, 2}
+};
+#else
+#error "No chain wiring (segmentOrder) for this reel layout"
+#endif
+
+#endif
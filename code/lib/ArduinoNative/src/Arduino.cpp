@@ -0,0 +1,251 @@
+#include <Arduino.h>
+#include <time.h>
+#include "ArduinoNative.h"
+
+#define MAX_PIN_LISTENERS 4
+
+struct NativePin {
+  uint8_t mode;
+  uint8_t output;   // level written by the sketch
+  uint8_t input;    // level driven from outside
+  bool    driven;   // input is driven, otherwise the pin floats or is pulled up
+};
+
+static NativePin pins[NUM_DIGITAL_PINS];
+static NativePinListener pinListeners[MAX_PIN_LISTENERS];
+static uint8_t pinListenerCount = 0;
+
+static void (*interruptHandlers[2])(void);
+static int  interruptModes[2];
+static bool interruptsEnabled = true;
+static bool interruptPending[2];
+
+static uint64_t bootTime = 0;
+static uint64_t virtualTime = 0;
+static double   speed = 0;
+static uint64_t wallStart = 0;
+static uint64_t virtualStart = 0;
+
+static uint64_t wallMicros() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint64_t nativeNow(void) {
+  return virtualTime;
+}
+
+void nativeAdvance(uint64_t us) {
+  virtualTime += us;
+  if (speed <= 0) {
+    return;
+  }
+  uint64_t due = wallStart + (uint64_t)((virtualTime - virtualStart) / speed);
+  uint64_t wall = wallMicros();
+  if (due > wall) {
+    struct timespec ts;
+    ts.tv_sec = (due - wall) / 1000000;
+    ts.tv_nsec = ((due - wall) % 1000000) * 1000;
+    nanosleep(&ts, NULL);
+  }
+}
+
+void nativeSetBootTime(uint64_t us) {
+  bootTime = us;
+}
+
+void nativeSetSpeed(double value) {
+  speed = value;
+  wallStart = wallMicros();
+  virtualStart = virtualTime;
+}
+
+unsigned long millis(void) {
+  return (uint32_t)((bootTime + virtualTime) / 1000);
+}
+
+unsigned long micros(void) {
+  return (uint32_t)(bootTime + virtualTime);
+}
+
+void delay(unsigned long ms) {
+  nativeAdvance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  nativeAdvance(us);
+}
+
+static void runInterrupt(uint8_t number) {
+  if (!interruptsEnabled) {
+    interruptPending[number] = true;
+    return;
+  }
+  interruptsEnabled = false;
+  interruptHandlers[number]();
+  interruptsEnabled = true;
+}
+
+static int readLevel(uint8_t pin) {
+  const NativePin &p = pins[pin];
+  if (p.mode == OUTPUT) {
+    return p.output;
+  }
+  if (p.driven) {
+    return p.input;
+  }
+  return p.mode == INPUT_PULLUP || p.output ? HIGH : LOW;
+}
+
+static void inputChanged(uint8_t pin, int before) {
+  int number = digitalPinToInterrupt(pin);
+  int after = readLevel(pin);
+  if (number < 0 || !interruptHandlers[number] || before == after) {
+    return;
+  }
+  int mode = interruptModes[number];
+  if (mode == CHANGE || (mode == FALLING && after == LOW) || (mode == RISING && after == HIGH)) {
+    runInterrupt(number);
+  }
+}
+
+static void outputChanged(uint8_t pin, int before) {
+  int after = readLevel(pin);
+  if (after == before) {
+    return;
+  }
+  for (uint8_t i = 0; i < pinListenerCount; i++) {
+    pinListeners[i](pin, after, virtualTime);
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= NUM_DIGITAL_PINS) {
+    return;
+  }
+  int before = readLevel(pin);
+  pins[pin].mode = mode;
+  if (mode == INPUT_PULLUP) {
+    pins[pin].output = HIGH;
+  }
+  outputChanged(pin, before);
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin >= NUM_DIGITAL_PINS) {
+    return;
+  }
+  int before = readLevel(pin);
+  pins[pin].output = val ? HIGH : LOW;
+  outputChanged(pin, before);
+}
+
+int digitalRead(uint8_t pin) {
+  if (pin >= NUM_DIGITAL_PINS) {
+    return LOW;
+  }
+  return readLevel(pin);
+}
+
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val) {
+  for (uint8_t i = 0; i < 8; i++) {
+    if (bitOrder == LSBFIRST) {
+      digitalWrite(dataPin, !!(val & (1 << i)));
+    } else {
+      digitalWrite(dataPin, !!(val & (1 << (7 - i))));
+    }
+    digitalWrite(clockPin, HIGH);
+    digitalWrite(clockPin, LOW);
+  }
+}
+
+void nativeSetInput(uint8_t pin, uint8_t level) {
+  if (pin >= NUM_DIGITAL_PINS) {
+    return;
+  }
+  int before = readLevel(pin);
+  pins[pin].input = level ? HIGH : LOW;
+  pins[pin].driven = true;
+  inputChanged(pin, before);
+}
+
+void nativeReleaseInput(uint8_t pin) {
+  if (pin >= NUM_DIGITAL_PINS) {
+    return;
+  }
+  int before = readLevel(pin);
+  pins[pin].driven = false;
+  inputChanged(pin, before);
+}
+
+void nativeAddPinListener(NativePinListener listener) {
+  if (pinListenerCount < MAX_PIN_LISTENERS) {
+    pinListeners[pinListenerCount++] = listener;
+  }
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode) {
+  if (interruptNum < 2) {
+    interruptHandlers[interruptNum] = userFunc;
+    interruptModes[interruptNum] = mode;
+  }
+}
+
+void detachInterrupt(uint8_t interruptNum) {
+  if (interruptNum < 2) {
+    interruptHandlers[interruptNum] = NULL;
+  }
+}
+
+void noInterrupts(void) {
+  interruptsEnabled = false;
+}
+
+void interrupts(void) {
+  interruptsEnabled = true;
+  for (uint8_t i = 0; i < 2; i++) {
+    if (interruptPending[i]) {
+      interruptPending[i] = false;
+      runInterrupt(i);
+    }
+  }
+}
+
+// avr-libc random(): Park-Miller minimal standard generator
+static uint32_t randomState = 1;
+
+static int32_t nextRandom() {
+  int32_t x = randomState;
+  if (x == 0) {
+    x = 123459876L;
+  }
+  int32_t hi = x / 127773L;
+  int32_t lo = x % 127773L;
+  x = 16807L * lo - 2836L * hi;
+  if (x < 0) {
+    x += 0x7fffffffL;
+  }
+  randomState = x;
+  return x;
+}
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0) {
+    randomState = (uint32_t)seed;
+  }
+}
+
+long random(long howbig) {
+  if (howbig == 0) {
+    return 0;
+  }
+  return nextRandom() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) {
+    return howsmall;
+  }
+  return random(howbig - howsmall) + howsmall;
+}
@@ -0,0 +1,73 @@
+/*
+  Host stand-in for the Arduino AVR core, used by the native environment.
+
+  Only what the firmware and the SevenSegment library use is provided. Time is
+  virtual: it only moves when the sketch waits or when the runner advances it
+  between two loop() calls, so runs are deterministic and as fast as the host.
+  Types keep their AVR meaning where it matters (millis() wraps at 32 bit).
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "binary.h"
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+#define HIGH          0x1
+#define LOW           0x0
+
+#define INPUT         0x0
+#define OUTPUT        0x1
+#define INPUT_PULLUP  0x2
+
+#define LSBFIRST      0
+#define MSBFIRST      1
+
+#define CHANGE        1
+#define FALLING       2
+#define RISING        3
+
+#define NUM_DIGITAL_PINS  20
+#define digitalPinToInterrupt(p)  ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+
+// time
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// digital io
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t val);
+
+// interrupts
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+void noInterrupts(void);
+void interrupts(void);
+
+// same generator as avr-libc, so a seed plays the same game on host and board
+void randomSeed(unsigned long seed);
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+template<class T, class U> inline T constrain(T amt, U low, U high) {
+  return amt < low ? low : (amt > high ? high : amt);
+}
+
+#include "WString.h"
+#include "Print.h"
+#include "HardwareSerial.h"
+
+#endif
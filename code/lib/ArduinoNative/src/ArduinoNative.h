@@ -0,0 +1,28 @@
+/*
+  Host side controls of the native environment: the virtual clock, the input pins
+  and hooks to observe what the sketch drives. Not available on the board.
+*/
+
+#ifndef ArduinoNative_h
+#define ArduinoNative_h
+
+#include <stdint.h>
+
+// Called for every level change of an output pin, at virtual time micros
+typedef void (*NativePinListener)(uint8_t pin, uint8_t level, uint64_t micros);
+
+// Virtual time since boot in microseconds (not wrapped like millis()/micros())
+uint64_t nativeNow(void);
+// Moves virtual time forward, pacing against the wall clock if a speed is set
+void     nativeAdvance(uint64_t micros);
+// Start the virtual clock at an offset, e.g. just before the 32 bit wrap of millis()
+void     nativeSetBootTime(uint64_t micros);
+// 0 runs as fast as possible, 1 in real time, 0.1 ten times slower
+void     nativeSetSpeed(double speed);
+
+// Level an external device drives onto an input pin, fires attached interrupts
+void     nativeSetInput(uint8_t pin, uint8_t level);
+void     nativeReleaseInput(uint8_t pin);
+void     nativeAddPinListener(NativePinListener listener);
+
+#endif
@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include <string.h>
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+static uint8_t cells[E2END + 1];
+static bool    erased = false;
+static FILE   *backing = NULL;
+
+static void ensureErased() {
+  if (!erased) {
+    memset(cells, 0xFF, sizeof(cells));
+    erased = true;
+  }
+}
+
+uint8_t EEPROMClass::read(int idx) {
+  ensureErased();
+  return cells[idx & E2END];
+}
+
+void EEPROMClass::write(int idx, uint8_t val) {
+  ensureErased();
+  cells[idx & E2END] = val;
+  if (backing) {
+    fseek(backing, idx & E2END, SEEK_SET);
+    fputc(val, backing);
+    fflush(backing);
+  }
+}
+
+void EEPROMClass::attach(const char *path) {
+  ensureErased();
+  backing = fopen(path, "r+b");
+  if (backing && fread(cells, 1, sizeof(cells), backing) == sizeof(cells)) {
+    return;
+  }
+  // missing or short file: start from erased cells
+  if (backing) {
+    fclose(backing);
+  }
+  memset(cells, 0xFF, sizeof(cells));
+  backing = fopen(path, "w+b");
+  if (backing) {
+    fwrite(cells, 1, sizeof(cells), backing);
+    fflush(backing);
+  }
+}
@@ -0,0 +1,41 @@
+// Arduino EEPROM library on a 1 KB host buffer, optionally backed by a file
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <stdint.h>
+
+#define E2END 0x3FF
+
+class EEPROMClass {
+public:
+  uint8_t read(int idx);
+  void    write(int idx, uint8_t val);
+  void    update(int idx, uint8_t val) {
+    if (read(idx) != val) {
+      write(idx, val);
+    }
+  }
+  uint16_t length() { return E2END + 1; }
+
+  template<typename T> T &get(int idx, T &t) {
+    uint8_t *ptr = (uint8_t *)&t;
+    for (unsigned int i = 0; i < sizeof(T); i++) {
+      ptr[i] = read(idx + i);
+    }
+    return t;
+  }
+  template<typename T> const T &put(int idx, const T &t) {
+    const uint8_t *ptr = (const uint8_t *)&t;
+    for (unsigned int i = 0; i < sizeof(T); i++) {
+      update(idx + i, ptr[i]);
+    }
+    return t;
+  }
+
+  // host side: keep the contents in this file across runs
+  void attach(const char *path);
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
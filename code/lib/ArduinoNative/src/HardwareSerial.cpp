@@ -0,0 +1,60 @@
+#include <errno.h>
+#include <unistd.h>
+#include "HardwareSerial.h"
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+void HardwareSerial::connect(int inFd, int outFd) {
+  _inFd = inFd;
+  _outFd = outFd;
+  _peeked = -1;
+}
+
+void HardwareSerial::capture(void (*sink)(uint8_t)) {
+  _sink = sink;
+}
+
+int HardwareSerial::available(void) {
+  return peek() >= 0 ? 1 : 0;
+}
+
+int HardwareSerial::peek(void) {
+  if (_peeked < 0 && _inFd >= 0) {
+    uint8_t c;
+    if (::read(_inFd, &c, 1) == 1) {
+      _peeked = c;
+    }
+  }
+  return _peeked;
+}
+
+int HardwareSerial::read(void) {
+  int c = peek();
+  _peeked = -1;
+  return c;
+}
+
+int HardwareSerial::availableForWrite(void) {
+  // the host drains immediately, so the whole buffer is always free
+  return SERIAL_TX_BUFFER_SIZE - 1;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (_sink) {
+    _sink(c);
+    return 1;
+  }
+  if (_outFd < 0) {
+    return 1;
+  }
+  while (::write(_outFd, &c, 1) < 0) {
+    if (errno != EAGAIN && errno != EINTR) {
+      return 0;
+    }
+  }
+  return 1;
+}
@@ -0,0 +1,36 @@
+// Serial port of the native environment, see NativeMain.cpp for where it is connected
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include "Print.h"
+
+#define SERIAL_TX_BUFFER_SIZE 64
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud);
+  void end() {}
+  virtual int available(void);
+  virtual int peek(void);
+  virtual int read(void);
+  virtual int availableForWrite(void);
+  void flush(void) {}
+  virtual size_t write(uint8_t);
+  using Print::write;
+  operator bool() { return true; }
+
+  // host side: file descriptors the port reads from and writes to (-1 for none)
+  void connect(int inFd, int outFd);
+  // host side: hands every written byte to sink instead of the output descriptor
+  void capture(void (*sink)(uint8_t));
+
+private:
+  int _inFd = -1;
+  int _outFd = 1;
+  int _peeked = -1;
+  void (*_sink)(uint8_t) = NULL;
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,103 @@
+/*
+  Entry point of the native environment: runs setup() and loop() under virtual time.
+
+  program [--duration ms] [--speed x] [--loop-us us] [--serial path | --pty] [--eeprom file]
+
+  Serial output goes to stdout unless --serial or --pty is given. --pty creates a
+  pseudo terminal and prints its name on stderr, so host tools can open it like a board.
+
+  Builds that define NATIVE_CUSTOM_MAIN bring their own main(), like the simulator in sim/.
+*/
+
+#ifndef NATIVE_CUSTOM_MAIN
+
+#define _XOPEN_SOURCE 600
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include "ArduinoNative.h"
+
+extern void setup(void);
+extern void loop(void);
+
+static int openPty() {
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0) {
+    perror("pty");
+    exit(1);
+  }
+  // raw mode, the serial line carries binary data
+  struct termios tio;
+  int slave = open(ptsname(fd), O_RDWR | O_NOCTTY);
+  if (slave >= 0 && tcgetattr(slave, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+  }
+  fprintf(stderr, "serial: %s\n", ptsname(fd));
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  return fd;
+}
+
+int main(int argc, char **argv) {
+  static const struct option options[] = {
+    {"duration", required_argument, NULL, 'd'},
+    {"speed",    required_argument, NULL, 's'},
+    {"loop-us",  required_argument, NULL, 'l'},
+    {"serial",   required_argument, NULL, 'p'},
+    {"pty",      no_argument,       NULL, 't'},
+    {"eeprom",   required_argument, NULL, 'e'},
+    {NULL, 0, NULL, 0}
+  };
+  uint64_t duration = 0;
+  uint64_t loopTime = 100;
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    switch (opt) {
+      case 'd':
+        duration = strtoull(optarg, NULL, 10) * 1000;
+        break;
+      case 's':
+        nativeSetSpeed(atof(optarg));
+        break;
+      case 'l':
+        loopTime = strtoull(optarg, NULL, 10);
+        break;
+      case 'p': {
+        int fd = open(optarg, O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd < 0) {
+          perror(optarg);
+          return 1;
+        }
+        Serial.connect(fd, fd);
+        break;
+      }
+      case 't': {
+        int fd = openPty();
+        Serial.connect(fd, fd);
+        break;
+      }
+      case 'e':
+        EEPROM.attach(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [--duration ms] [--speed x] [--loop-us us] "
+                        "[--serial path | --pty] [--eeprom file]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  setup();
+  while (duration == 0 || nativeNow() < duration) {
+    loop();
+    nativeAdvance(loopTime);
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "WString.h"
+
+String::String(const char *cstr) : _buffer(NULL), _len(0) {
+  assign(cstr, strlen(cstr));
+}
+
+String::String(const String &str) : _buffer(NULL), _len(0) {
+  assign(str._buffer, str._len);
+}
+
+String::String(char c) : _buffer(NULL), _len(0) {
+  assign(&c, 1);
+}
+
+String::String(int value, unsigned char base) : _buffer(NULL), _len(0) {
+  assignNumber(value < 0 ? -(long)value : value, value < 0, base);
+}
+
+String::String(unsigned int value, unsigned char base) : _buffer(NULL), _len(0) {
+  assignNumber(value, false, base);
+}
+
+String::String(long value, unsigned char base) : _buffer(NULL), _len(0) {
+  assignNumber(value < 0 ? -(unsigned long)value : value, value < 0, base);
+}
+
+String::String(unsigned long value, unsigned char base) : _buffer(NULL), _len(0) {
+  assignNumber(value, false, base);
+}
+
+String::~String() {
+  free(_buffer);
+}
+
+String &String::operator=(const String &rhs) {
+  if (this != &rhs) {
+    assign(rhs._buffer, rhs._len);
+  }
+  return *this;
+}
+
+String &String::operator+=(const String &rhs) {
+  char *buffer = (char *)realloc(_buffer, _len + rhs._len + 1);
+  if (buffer) {
+    memcpy(buffer + _len, rhs._buffer, rhs._len + 1);
+    _buffer = buffer;
+    _len += rhs._len;
+  }
+  return *this;
+}
+
+String operator+(const String &lhs, const String &rhs) {
+  String result(lhs);
+  result += rhs;
+  return result;
+}
+
+void String::assign(const char *cstr, unsigned int length) {
+  char *buffer = (char *)malloc(length + 1);
+  memcpy(buffer, cstr, length);
+  buffer[length] = '\0';
+  free(_buffer);
+  _buffer = buffer;
+  _len = length;
+}
+
+void String::assignNumber(unsigned long value, bool negative, unsigned char base) {
+  char buf[8 * sizeof(long) + 2];
+  char *str = &buf[sizeof(buf) - 1];
+
+  *str = '\0';
+  do {
+    char c = value % base;
+    value /= base;
+    *--str = c < 10 ? c + '0' : c + 'a' - 10;
+  } while (value);
+  if (negative) {
+    *--str = '-';
+  }
+  assign(str, strlen(str));
+}
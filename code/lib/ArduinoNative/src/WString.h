@@ -0,0 +1,34 @@
+// Minimal Arduino String, enough for building short display texts
+#ifndef String_class_h
+#define String_class_h
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class String {
+public:
+  String(const char *cstr = "");
+  String(const String &str);
+  explicit String(char c);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  ~String();
+
+  String &operator=(const String &rhs);
+  String &operator+=(const String &rhs);
+  friend String operator+(const String &lhs, const String &rhs);
+
+  unsigned int length(void) const { return _len; }
+  const char  *c_str(void) const { return _buffer; }
+
+private:
+  void assign(const char *cstr, unsigned int length);
+  void assignNumber(unsigned long value, bool negative, unsigned char base);
+
+  char         *_buffer;
+  unsigned int  _len;
+};
+
+#endif
@@ -0,0 +1,22 @@
+// Host stand-in for avr-libc's flash access, flash and RAM are the same thing here
+#ifndef __PGMSPACE_H_
+#define __PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)                 (s)
+#define pgm_read_byte(p)        (*(const uint8_t *)(p))
+#define pgm_read_byte_near(p)   pgm_read_byte(p)
+#define pgm_read_word(p)        (*(const uint16_t *)(p))
+#define pgm_read_word_near(p)   pgm_read_word(p)
+#define pgm_read_dword(p)       (*(const uint32_t *)(p))
+#define pgm_read_ptr(p)         (*(void * const *)(p))
+#define memcpy_P                memcpy
+#define strlen_P                strlen
+#define strcmp_P                strcmp
+#define strncpy_P               strncpy
+#define strncmp_P               strncmp
+
+#endif
@@ -0,0 +1,129 @@
+/*
+  FastGPIO - compile time pin access and an unrolled shift out for 74HC595 chains
+
+  The pin number is a template parameter, so port, DDR and bit mask are constants and
+  every access compiles to a single sbi/cbi/sbis instruction on the ATmega328. Compare
+  digitalWrite(), which looks the pin up in three flash tables, checks for a PWM timer
+  and disables interrupts on every call.
+
+  For a 9 byte chain, 72 bits through shiftOut() take roughly 700 us on a 16 MHz Uno,
+  ShiftRegisterChain::write() about 40 us. Both are estimates from the instructions per
+  bit, not measurements; bench/shift_register.cpp times the two on the board.
+
+  On other boards (and in the native environment) it falls back to the Arduino calls,
+  like the direct port macros in SevenSegmentTM1637.h. Method names stay clear of
+  those macros (isHigh, digitalLow, ...) so both headers can be included together.
+*/
+
+#ifndef FastGPIO_H
+#define FastGPIO_H
+
+#include <Arduino.h>
+
+#if defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega328P__)
+  #define FASTGPIO_DIRECT_PORTS 1
+#else
+  #define FASTGPIO_DIRECT_PORTS 0
+#endif
+
+template<uint8_t Pin>
+class FastPin {
+  static_assert(Pin < 20, "FastPin only knows the digital and analog pins of the Uno");
+
+public:
+  // bit of the pin in its port, 0-13 are digital, 14-19 analog
+  static const uint8_t mask = 1 << (Pin < 8 ? Pin : (Pin < 14 ? Pin - 8 : Pin - 14));
+
+#if FASTGPIO_DIRECT_PORTS
+  static inline void output()      { *ddr() |= mask; }
+  static inline void input()       { *ddr() &= ~mask; *port() &= ~mask; }
+  static inline void inputPullUp() { *ddr() &= ~mask; *port() |= mask; }
+  static inline void high()        { *port() |= mask; }
+  static inline void low()         { *port() &= ~mask; }
+  static inline bool read()        { return (*pin() & mask) != 0; }
+  // writing a one to PINx toggles the output on the ATmega328
+  static inline void toggle()      { *pin() = mask; }
+
+private:
+  static inline volatile uint8_t *port() { return Pin < 8 ? &PORTD : (Pin < 14 ? &PORTB : &PORTC); }
+  static inline volatile uint8_t *ddr()  { return Pin < 8 ? &DDRD  : (Pin < 14 ? &DDRB  : &DDRC); }
+  static inline volatile uint8_t *pin()  { return Pin < 8 ? &PIND  : (Pin < 14 ? &PINB  : &PINC); }
+
+public:
+#else
+  static inline void output()      { pinMode(Pin, OUTPUT); }
+  static inline void input()       { pinMode(Pin, INPUT); }
+  static inline void inputPullUp() { pinMode(Pin, INPUT_PULLUP); }
+  static inline void high()        { digitalWrite(Pin, HIGH); }
+  static inline void low()         { digitalWrite(Pin, LOW); }
+  static inline bool read()        { return digitalRead(Pin) == HIGH; }
+  static inline void toggle()      { digitalWrite(Pin, !digitalRead(Pin)); }
+#endif
+
+  static inline void write(bool value) {
+    if (value) {
+      high();
+    } else {
+      low();
+    }
+  }
+};
+
+/*
+Chain of 74HC595 shift registers on three pins, shifted out LSB first like
+shiftOut(dataPin, clockPin, LSBFIRST, value). The first byte written ends up in
+the register furthest from the data pin.
+*/
+template<uint8_t DataPin, uint8_t ClockPin, uint8_t LatchPin>
+class ShiftRegisterChain {
+public:
+  typedef FastPin<DataPin>  Data;
+  typedef FastPin<ClockPin> Clock;
+  typedef FastPin<LatchPin> Latch;
+
+  static void begin() {
+    Data::output();
+    Clock::output();
+    Latch::output();
+    Clock::low();
+  }
+
+  // Shifts one byte into the chain without latching it
+  static inline void shift(uint8_t value) {
+    shiftBit(value, 0x01);
+    shiftBit(value, 0x02);
+    shiftBit(value, 0x04);
+    shiftBit(value, 0x08);
+    shiftBit(value, 0x10);
+    shiftBit(value, 0x20);
+    shiftBit(value, 0x40);
+    shiftBit(value, 0x80);
+  }
+
+  // Shifts length bytes and latches them onto the outputs
+  static void write(const uint8_t *data, uint8_t length) {
+    Latch::low();
+    for (uint8_t i = 0; i < length; i++) {
+      shift(data[i]);
+    }
+    Latch::high();
+  }
+
+  // Sets every register of a chain of length to the same value
+  static void fill(uint8_t value, uint8_t length) {
+    Latch::low();
+    for (uint8_t i = 0; i < length; i++) {
+      shift(value);
+    }
+    Latch::high();
+  }
+
+private:
+  static inline void shiftBit(uint8_t value, uint8_t bit) {
+    Data::write(value & bit);
+    Clock::high();
+    Clock::low();
+  }
+};
+
+#endif
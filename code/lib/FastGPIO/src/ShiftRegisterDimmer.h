@@ -0,0 +1,262 @@
+/*
+  ShiftRegisterDimmer - double buffered 74HC595 chain with brightness levels, refreshed
+  from Timer2 by binary code modulation
+
+  The /OE pin of all registers goes to OePin. Timer2 splits every refresh period into
+  Bits planes of 1, 2, 4, ... base time units. A digit is lit during the planes whose
+  bit is set in its level, so it is on for level / maxLevel of the time. The Timer2
+  compare interrupt fires once per plane:
+
+    - planes where no digit is lit just pull /OE high
+    - planes that look like the one before only leave /OE low
+    - only when digits have different levels a plane is shifted in and latched
+
+  With 4 bits and a base of 64 us the period is 960 us (about 1 kHz, no flicker), so
+  that is 4 interrupts per millisecond, a few us each, about 45 us when a 9 byte plane
+  has to be shifted (ShiftRegisterChain::write()).
+
+  Frames are double buffered. The sketch renders into back() and calls publish(), which
+  splits the frame into planes and makes it the front buffer with a single byte write.
+  The interrupt takes the front buffer over at its next plane, so the reels never show
+  half a frame and the refresh keeps its cadence however long the loop takes.
+
+  Timer2 is set up in CTC mode with prescaler 64, only OCR2A/COMPA is used. The sketch
+  has to forward the interrupt:
+
+    typedef ShiftRegisterDimmer<Registers, 7, 9> Reels;
+    ISR(TIMER2_COMPA_vect) { Reels::tick(); }
+
+  Without Timer2 (other boards, native environment) publish() latches every digit with
+  a level above zero directly and the levels are only remembered.
+*/
+
+#ifndef ShiftRegisterDimmer_H
+#define ShiftRegisterDimmer_H
+
+#include <Arduino.h>
+#include "FastGPIO.h"
+
+#if FASTGPIO_DIRECT_PORTS
+  #define SHIFT_REGISTER_DIMMER_TIMER2 1
+#else
+  #define SHIFT_REGISTER_DIMMER_TIMER2 0
+#endif
+
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits = 4>
+class ShiftRegisterDimmer {
+  static_assert(Bits >= 1 && Bits <= 4, "the longest plane has to fit into the 8 bit Timer2");
+
+public:
+  typedef FastPin<OePin> Enable;              // /OE of the chain, low = outputs on
+  static const uint8_t maxLevel = (1 << Bits) - 1;
+  static const uint8_t baseTicks = 16;        // Timer2 ticks of 4 us in the shortest plane
+
+  // Sets up the chain, /OE and Timer2, all digits dark at full level
+  static void begin() {
+    Enable::high();
+    Enable::output();
+    Chain::begin();
+    for (uint8_t i = 0; i < Length; i++) {
+      _levels[i] = maxLevel;
+    }
+    memset(back(), 0, Length);
+    publish();
+    _current = _front;                        // nothing to take over before the timer runs
+#if SHIFT_REGISTER_DIMMER_TIMER2
+    noInterrupts();
+    TCCR2A = _BV(WGM21);                      // CTC, TOP = OCR2A
+    TCCR2B = _BV(CS22);                       // clk / 64
+    OCR2A = baseTicks - 1;
+    TCNT2 = 0;
+    TIMSK2 |= _BV(OCIE2A);
+    interrupts();
+#endif
+  }
+
+  /* Buffer to render the next frame into, one segment byte per register, the first
+  * byte goes furthest down the chain. It holds an older frame, write every byte.
+  * Waits (one plane at most) while the interrupt has not taken over the last frame,
+  * so never call it with interrupts disabled.
+  */
+  static uint8_t *back() {
+#if SHIFT_REGISTER_DIMMER_TIMER2
+    while (_current != _front) {
+    }
+    // the interrupt is done with the old frame, writes into it must not move up
+    asm volatile("" ::: "memory");
+#endif
+    return _segments[_front ^ 1];
+  }
+
+  // Makes the back buffer the front buffer, does nothing if it shows the same as the front
+  static void publish() {
+    uint8_t next = _front ^ 1;
+    if (!_levelsChanged && _published && memcmp(_segments[next], _segments[_front], Length) == 0) {
+      return;
+    }
+    _levelsChanged = false;
+    _published = true;
+    split(next);
+    // the planes are complete in RAM before the interrupt may take them over, the
+    // compiler would otherwise be free to sink their stores past the volatile one
+    asm volatile("" ::: "memory");
+    _front = next;
+#if !SHIFT_REGISTER_DIMMER_TIMER2
+    _current = next;
+#endif
+  }
+
+  // Shows a frame, see back() for the order
+  static void show(const uint8_t *segments) {
+    memcpy(back(), segments, Length);
+    publish();
+  }
+
+  // Sets every register to the same segments
+  static void fill(uint8_t value) {
+    memset(back(), value, Length);
+    publish();
+  }
+
+  // Level 0 (dark) to maxLevel (always on) for every digit
+  static void setLevel(uint8_t level) {
+    level = level > maxLevel ? maxLevel : level;
+    for (uint8_t i = 0; i < Length; i++) {
+      _levelsChanged |= _levels[i] != level;
+      _levels[i] = level;
+    }
+    republish();
+  }
+
+  // Level of a single digit, for fades and highlights
+  static void setLevel(uint8_t digit, uint8_t level) {
+    level = level > maxLevel ? maxLevel : level;
+    if (digit < Length && _levels[digit] != level) {
+      _levels[digit] = level;
+      _levelsChanged = true;
+      republish();
+    }
+  }
+
+  static uint8_t level(uint8_t digit) {
+    return digit < Length ? _levels[digit] : 0;
+  }
+
+  // Timer2 compare interrupt: starts the next plane
+  static inline void tick() {
+#if SHIFT_REGISTER_DIMMER_TIMER2
+    uint8_t plane = _plane;
+    // the counter restarted at the match, set the length of this plane first
+    OCR2A = (baseTicks << plane) - 1;
+    uint8_t buffer = _front;
+    if (buffer != _current) {
+      _current = buffer;
+      _stale = true;                          // the chain still holds the old frame
+    }
+    uint8_t bit = 1 << plane;
+    if (_darkPlanes[buffer] & bit) {
+      Enable::high();
+    } else {
+      if (_stale || (_shiftPlanes[buffer] & bit)) {
+        Chain::write(_planes[buffer][plane], Length);
+        _stale = false;
+      }
+      Enable::low();
+    }
+    _plane = plane + 1 < Bits ? plane + 1 : 0;
+#endif
+  }
+
+private:
+  // Publishes the front frame again with the new levels
+  static void republish() {
+    if (_levelsChanged) {
+      memcpy(back(), _segments[_front], Length);
+      publish();
+    }
+  }
+
+  // Splits segments and levels of a buffer into its planes
+  static void split(uint8_t buffer) {
+    const uint8_t *segments = _segments[buffer];
+#if SHIFT_REGISTER_DIMMER_TIMER2
+    uint8_t (*planes)[Length] = _planes[buffer];
+    uint8_t dark = 0;
+    for (uint8_t k = 0; k < Bits; k++) {
+      bool lit = false;
+      for (uint8_t i = 0; i < Length; i++) {
+        planes[k][i] = (_levels[i] >> k) & 1 ? segments[i] : 0;
+        lit |= planes[k][i] != 0;
+      }
+      dark |= lit ? 0 : 1 << k;
+    }
+
+    // a lit plane needs a shift unless the lit plane before it (cyclic) is the same
+    uint8_t shift = 0;
+    for (uint8_t k = 0; k < Bits; k++) {
+      if (dark & (1 << k)) {
+        continue;
+      }
+      uint8_t previous = k;
+      do {
+        previous = previous > 0 ? previous - 1 : Bits - 1;
+      } while (dark & (1 << previous));
+      if (previous != k && memcmp(planes[k], planes[previous], Length) != 0) {
+        shift |= 1 << k;
+      }
+    }
+    _darkPlanes[buffer] = dark;
+    _shiftPlanes[buffer] = shift;
+#else
+    uint8_t frame[Length];
+    bool lit = false;
+    for (uint8_t i = 0; i < Length; i++) {
+      frame[i] = _levels[i] > 0 ? segments[i] : 0;
+      lit |= frame[i] != 0;
+    }
+    Chain::write(frame, Length);
+    Enable::write(!lit);
+#endif
+  }
+
+  static uint8_t _segments[2][Length];
+  static uint8_t _levels[Length];
+  static bool    _levelsChanged;
+  static bool    _published;                  // false until the first frame
+  static volatile uint8_t _front;             // buffer published last
+  static volatile uint8_t _current;           // buffer the interrupt shows
+#if SHIFT_REGISTER_DIMMER_TIMER2
+  static uint8_t _planes[2][Bits][Length];
+  static uint8_t _darkPlanes[2];              // bit k: nothing lit in plane k
+  static uint8_t _shiftPlanes[2];             // bit k: plane k differs from the lit plane before it
+  static volatile uint8_t _plane;             // plane the timer shows next
+  static volatile bool _stale;                // the chain has not latched the current frame yet
+#endif
+};
+
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+uint8_t ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_segments[2][Length];
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+uint8_t ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_levels[Length];
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+bool ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_levelsChanged = false;
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+bool ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_published = false;
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+volatile uint8_t ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_front = 0;
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+volatile uint8_t ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_current = 0;
+#if SHIFT_REGISTER_DIMMER_TIMER2
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+uint8_t ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_planes[2][Bits][Length];
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+uint8_t ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_darkPlanes[2] = {0xFF, 0xFF};
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+uint8_t ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_shiftPlanes[2];
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+volatile uint8_t ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_plane = 0;
+template<class Chain, uint8_t OePin, uint8_t Length, uint8_t Bits>
+volatile bool ShiftRegisterDimmer<Chain, OePin, Length, Bits>::_stale = true;
+#endif
+
+#endif
@@ -100,6 +100,9 @@ const PROGMEM uint8_t asciiMap[96] = {
   TM1637_CHAR_TILDE     // 126 (ASCII)
 };
 
+uint8_t TM1637Bus::halfPeriod = TM1637_CLK_DELAY_US;
+uint8_t TM1637Bus::transfers  = 0;
+uint8_t TM1637Bus::failures   = 0;
 
 SevenSegmentTM1637::SevenSegmentTM1637(uint8_t pinClk, uint8_t pinDIO) :
   _pinClk(pinClk),
@@ -111,6 +114,11 @@ SevenSegmentTM1637::SevenSegmentTM1637(uint8_t pinClk, uint8_t pinDIO) :
   digitalHigh(_pinClk);
   digitalHigh(_pinDIO);
 
+  // nothing is known about the display yet
+  _shownValid = false;
+  _sentControl = 0;
+  _onControl = TM1637_COM_SET_DISPLAY | TM1637_SET_DISPLAY_ON | TM1637_SET_DISPLAY_14;
+
   // setup defaults
   setCursor(0, TM1637_DEFAULT_CURSOR_POS);
   setPrintDelay(TM1637_DEFAULT_PRINT_DELAY);
@@ -145,7 +153,7 @@ size_t  SevenSegmentTM1637::write(uint8_t byte) {
     printRaw( _rawBuffer, _cursorPos+1, 0);
     setCursor(1, _cursorPos + 1);
   };
-
+  return 1;
 }
 
 // null terminated char array
@@ -164,6 +172,7 @@ size_t  SevenSegmentTM1637::write(const char* str) {
       break;
     }
   }
+  return i;
 };
 
 // byte array with length
@@ -177,6 +186,7 @@ size_t  SevenSegmentTM1637::write(const uint8_t* buffer, size_t size) {
   size_t length = encode(encodedBytes, buffer, size);
   TM1637_DEBUG_PRINT(F(" ")); TM1637_DEBUG_PRINTLN(encodedBytes[0], BIN);
   printRaw(encodedBytes,length, _cursorPos);
+  return length;
 };
 
 // Liquid cristal API
@@ -244,11 +254,22 @@ void SevenSegmentTM1637::setBacklight(uint8_t value) {
       cmd |= TM1637_SET_DISPLAY_ON | TM1637_SET_DISPLAY_14;
       break;
     };
-    bool ack = command(cmd);
-    TM1637_DEBUG_PRINT(F("SET_DISPLAY:\t")); TM1637_DEBUG_PRINTLN((
-      cmd
-    ), BIN);
-    TM1637_DEBUG_PRINT(F("Acknowledged:\t")); TM1637_DEBUG_PRINTLN(ack);
+    if ( value > 0 ) {
+      _onControl = cmd;                 // on() comes back to this brightness
+    }
+    sendControl(cmd);
+};
+
+void SevenSegmentTM1637::sendControl(uint8_t cmd) {
+  if ( cmd == _sentControl ) {          // display already runs with it
+    return;
+  }
+  bool ack = command(cmd);
+  _sentControl = (ack)?cmd:0;
+  TM1637_DEBUG_PRINT(F("SET_DISPLAY:\t")); TM1637_DEBUG_PRINTLN((
+    cmd
+  ), BIN);
+  TM1637_DEBUG_PRINT(F("Acknowledged:\t")); TM1637_DEBUG_PRINTLN(ack);
 };
 
 void SevenSegmentTM1637::setContrast(uint8_t value) {
@@ -256,12 +277,11 @@ void SevenSegmentTM1637::setContrast(uint8_t value) {
 }
 
 void SevenSegmentTM1637::on(void) {
-  setBacklight(TM1637_DEFAULT_BACKLIGHT);
+  sendControl(_onControl);
 };
 
 void SevenSegmentTM1637::off(void) {
-  setBacklight(0);
-  clear();
+  sendControl(TM1637_COM_SET_DISPLAY | TM1637_SET_DISPLAY_OFF);
 };
 
 // SevenSegmentTM1637 public methods
@@ -290,7 +310,14 @@ void  SevenSegmentTM1637::printRaw(uint8_t rawByte, uint8_t position) {
   cmd[0] = TM1637_COM_SET_ADR | position;
   cmd[1] = rawByte;
   if (position == 1) { cmd[1]|=(_colonOn)?TM1637_COLON_BIT:0; };
-  command(cmd, 2);
+  if ( _shownValid && position < TM1637_MAX_COLOM && _shown[position] == cmd[1] ) {
+    return;                             // display shows it already
+  }
+  bool ack = command(cmd, 2);
+  if ( position < TM1637_MAX_COLOM ) {
+    _shown[position] = cmd[1];
+  }
+  _shownValid &= ack;
 };
 
 void  SevenSegmentTM1637::printRaw(const uint8_t* rawBytes, size_t length, uint8_t position) {
@@ -311,9 +338,24 @@ void  SevenSegmentTM1637::printRaw(const uint8_t* rawBytes, size_t length, uint8
         cmd[1] |= (_colonOn)?TM1637_COLON_BIT:0;
       }
     }
-    TM1637_DEBUG_PRINT(F("ADDR :\t")); TM1637_DEBUG_PRINTLN(cmd[0],BIN);
-    TM1637_DEBUG_PRINT(F("DATA0:\t")); TM1637_DEBUG_PRINTLN(cmd[1],BIN);
-    command(cmd, length+1);                           // send to display
+    // only send the range between the first and last digit that changed
+    uint8_t first = 0;
+    uint8_t last  = length;
+    if ( _shownValid ) {
+      while ( first < last && cmd[first+1] == _shown[position+first] ) { first++; };
+      while ( last > first && cmd[last] == _shown[position+last-1] ) { last--; };
+      if ( first == last ) {
+        return;                         // nothing changed
+      }
+    }
+    memcpy(&_shown[position+first], &cmd[first+1], last-first);
+    cmd[first] = TM1637_COM_SET_ADR | ((position+first) & B111);
+
+    TM1637_DEBUG_PRINT(F("ADDR :\t")); TM1637_DEBUG_PRINTLN(cmd[first],BIN);
+    TM1637_DEBUG_PRINT(F("DATA0:\t")); TM1637_DEBUG_PRINTLN(cmd[first+1],BIN);
+    bool ack = command(&cmd[first], last-first+1);    // send to display
+    // after a lost byte the display may hold anything, until all digits were sent again
+    _shownValid = ack && (_shownValid || (position == 0 && length >= TM1637_MAX_COLOM));
   }
   // does not fit on display, need to print with delay
   else {
@@ -426,7 +468,7 @@ uint8_t SevenSegmentTM1637::comReadByte(void) const {
     digitalHigh(_pinClk);
 
     if ( isHigh(_pinDIO) ) {
-      readKey = readKey | B1000000;
+      readKey = readKey | B10000000;
     };
 
     delayMicroseconds(30);
@@ -453,12 +495,12 @@ void    SevenSegmentTM1637::comWriteByte(uint8_t pinClk, uint8_t pinDIO, uint8_t
     } else {
       digitalLow(pinDIO); // DIO LOW
     }
-    delayMicroseconds(TM1637_CLK_DELAY_US);
+    delayMicroseconds(TM1637Bus::halfPeriod);
 
     command >>= 1;
 
     digitalHigh(pinClk);   // CLK HIGH
-    delayMicroseconds(TM1637_CLK_DELAY_US);
+    delayMicroseconds(TM1637Bus::halfPeriod);
   };
 }
 
@@ -469,7 +511,7 @@ void    SevenSegmentTM1637::comStart(void) const {
 void    SevenSegmentTM1637::comStart(uint8_t pinClk, uint8_t pinDIO) {
   digitalHigh(pinDIO);   // DIO HIGH
   digitalHigh(pinClk);   // CLK HIGH
-  delayMicroseconds(TM1637_CLK_DELAY_US);
+  delayMicroseconds(TM1637Bus::halfPeriod);
 
   digitalLow(pinDIO);    // DIO  LOW
 }
@@ -480,19 +522,19 @@ void    SevenSegmentTM1637::comStop(void) const {
 
 void    SevenSegmentTM1637::comStop(uint8_t pinClk, uint8_t pinDIO) {
   digitalLow(pinClk);   // CLK LOW
-  delayMicroseconds(TM1637_CLK_DELAY_US);
+  delayMicroseconds(TM1637Bus::halfPeriod);
 
   digitalLow(pinDIO);    // DIO LOW
-  delayMicroseconds(TM1637_CLK_DELAY_US);
+  delayMicroseconds(TM1637Bus::halfPeriod);
 
   digitalHigh(pinClk);   // CLK HIGH
-  delayMicroseconds(TM1637_CLK_DELAY_US);
+  delayMicroseconds(TM1637Bus::halfPeriod);
 
   digitalHigh(pinDIO);   // DIO HIGH
 }
 
 bool    SevenSegmentTM1637::comAck(void) const {
-  comAck(_pinClk, _pinDIO);
+  return comAck(_pinClk, _pinDIO);
 };
 
 bool    SevenSegmentTM1637::comAck(uint8_t pinClk, uint8_t pinDIO) {
@@ -500,15 +542,16 @@ bool    SevenSegmentTM1637::comAck(uint8_t pinClk, uint8_t pinDIO) {
 
   digitalLow(pinClk);          // CLK  LOW
   pinAsInputPullUp(pinDIO);    // DIO INPUT PULLUP (state==HIGH)
-  delayMicroseconds(TM1637_CLK_DELAY_US);
+  delayMicroseconds(TM1637Bus::halfPeriod);
 
   acknowledged = isLow(pinDIO);// Ack should pull the pin low again
 
   digitalHigh(pinClk);         // CLK HIGH
-  delayMicroseconds(TM1637_CLK_DELAY_US);
+  delayMicroseconds(TM1637Bus::halfPeriod);
 
   digitalLow(pinClk);          // CLK  LOW
   pinAsOutput(pinDIO);
 
+  TM1637Bus::record(acknowledged);
   return acknowledged;
 }
@@ -23,7 +23,9 @@
 #include <avr/pgmspace.h>   // Used for PROGMEM
 
 // COMPILE TIME USER CONFIG ////////////////////////////////////////////////////
-#define TM1637_DEBUG                  true   // true for serial debugging
+#ifndef TM1637_DEBUG
+#define TM1637_DEBUG                  false   // true for serial debugging (garbles binary serial protocols)
+#endif
 #define TM1637_BEGIN_DELAY            500     // ms
 #define TM1637_PRINT_BUFFER_SIZE      128     // lower if you don't need it
 
@@ -42,6 +44,7 @@
 // PROGRAM CONFIG (ONLY CHANGE WHEN YOU KNOW WHAT YOU RE DOING:)////////////////
 #define TM1637_CLK_DELAY_US 5           // clock delay for communication
 // mine works with 1us, perhaps increase if display does not function ( tested upto 1ms)
+// This is the start value of TM1637Bus::halfPeriod, see TM1637Calibration.h to find the fastest one at runtime
 
 
 // COMMANDS ////////////////////////////////////////////////////////////////////
@@ -96,6 +99,27 @@
 
 */
 
+// RUNTIME BUS TIMING //////////////////////////////////////////////////////////
+/* Half clock period of the bus, shared by SevenSegmentTM1637 and TM1637<Clk, Dio>
+* Every acknowledge is counted, so the failure rate of a faster period can be watched.
+*/
+struct TM1637Bus {
+  static uint8_t halfPeriod;        // us, starts at TM1637_CLK_DELAY_US
+  static uint8_t transfers;         // acknowledges since the last reset (saturates)
+  static uint8_t failures;          // missing acknowledges since the last reset
+
+  static void    record(bool acknowledged) {
+    if (transfers < 255) {
+      transfers++;
+      failures += acknowledged ? 0 : 1;
+    }
+  }
+  static void    resetCounters(void) {
+    transfers = 0;
+    failures = 0;
+  }
+};
+
 class SevenSegmentTM1637 : public Print {
 
 public:
@@ -155,11 +179,11 @@ public:
   void    setContrast(uint8_t value);
 
   /* Turns the display ON
-  * Identical to setting the brightness to the default value.
+  * Back at the last brightness set, only the display control command is sent.
   */
   void    on(void);
-  /* Turns the display ON
-  * Identical to setting the brightness to zero and clearing the display.
+  /* Turns the display OFF
+  * Only the display control command is sent, the digits stay in the display RAM for on().
   */
   void    off(void);
 
@@ -233,6 +257,7 @@ public:
   * Bit 7 (X) only applies to the second digit and sets the colon
   *
   /* Print raw (binary encodes) bytes to the display
+  * Digits the display already shows are skipped, the rest goes out with a single address command.
   @param [in] rawBytes      Array of raw bytes
   @param [in] length        optional: length to print to display
   @param [in] position      optional: Start position
@@ -249,8 +274,8 @@ public:
   */
   bool    command(uint8_t cmd) const;
   bool    command(const uint8_t* command, uint8_t length) const;
-  /* Read bytes from IC TM1637
-  * The IC also can read the state of a keypad? TODO untested
+  /* Read the key scan code from IC TM1637
+  @return key code        0xFF if no key is pressed
   */
   uint8_t comReadByte(void) const;
   /* Write a single command to the display
@@ -289,107 +314,17 @@ protected:
   uint16_t  _printDelay;              // print delay in ms (multiple chars)
   uint8_t   _colonOn;                 // colon bit if set
   uint8_t   _rawBuffer[TM1637_MAX_COLOM];// hold the last chars printed to display
+  // What the IC actually holds, so unchanged digits and settings are not sent again
+  uint8_t   _shown[TM1637_MAX_COLOM];   // display RAM as last written
+  bool      _shownValid;              // _shown matches the display RAM
+  uint8_t   _sentControl;             // last acknowledged display control command, 0 if unknown
+  uint8_t   _onControl;               // display control command used by on()
+
+  void      sendControl(uint8_t cmd);
 };
 
 
-#define TM1637_COLON_BIT        B10000000
-
-// ASCII MAPPINGS
-#define TM1637_CHAR_SPACE       B00000000 // 32  (ASCII)
-#define TM1637_CHAR_EXC         B00000110
-#define TM1637_CHAR_D_QUOTE     B00100010
-#define TM1637_CHAR_POUND       B01110110
-#define TM1637_CHAR_DOLLAR      B01101101
-#define TM1637_CHAR_PERC        B00100100
-#define TM1637_CHAR_AMP         B01111111
-#define TM1637_CHAR_S_QUOTE     B00100000
-#define TM1637_CHAR_L_BRACKET   B00111001
-#define TM1637_CHAR_R_BRACKET   B00001111
-#define TM1637_CHAR_STAR        B01011100
-#define TM1637_CHAR_PLUS        B01010000
-#define TM1637_CHAR_COMMA       B00010000
-#define TM1637_CHAR_MIN         B01000000
-#define TM1637_CHAR_DOT         B00001000
-#define TM1637_CHAR_F_SLASH     B00000110
-#define TM1637_CHAR_0           B00111111   // 48
-#define TM1637_CHAR_1           B00000110
-#define TM1637_CHAR_2           B01011011
-#define TM1637_CHAR_3           B01001111
-#define TM1637_CHAR_4           B01100110
-#define TM1637_CHAR_5           B01101101
-#define TM1637_CHAR_6           B01111101
-#define TM1637_CHAR_7           B00000111
-#define TM1637_CHAR_8           B01111111
-#define TM1637_CHAR_9           B01101111
-#define TM1637_CHAR_COLON       B00110000
-#define TM1637_CHAR_S_COLON     B00110000
-#define TM1637_CHAR_LESS        B01011000
-#define TM1637_CHAR_EQUAL       B01001000
-#define TM1637_CHAR_GREAT       B01001100
-#define TM1637_CHAR_QUEST       B01010011
-#define TM1637_CHAR_AT          B01011111
-#define TM1637_CHAR_A           B01110111 // 65  (ASCII)
-#define TM1637_CHAR_B           B01111111
-#define TM1637_CHAR_C           B00111001
-#define TM1637_CHAR_D           TM1637_CHAR_d
-#define TM1637_CHAR_E           B01111001
-#define TM1637_CHAR_F           B01110001
-#define TM1637_CHAR_G           B00111101
-#define TM1637_CHAR_H           B01110110
-#define TM1637_CHAR_I           B00000110
-#define TM1637_CHAR_J           B00001110
-#define TM1637_CHAR_K           B01110101
-#define TM1637_CHAR_L           B00111000
-#define TM1637_CHAR_M           B00010101
-#define TM1637_CHAR_N           B00110111
-#define TM1637_CHAR_O           B00111111
-#define TM1637_CHAR_P           B01110011
-#define TM1637_CHAR_Q           B01100111
-#define TM1637_CHAR_R           B00110011
-#define TM1637_CHAR_S           B01101101
-#define TM1637_CHAR_T           TM1637_CHAR_t
-#define TM1637_CHAR_U           B00111110
-#define TM1637_CHAR_V           B00011100
-#define TM1637_CHAR_W           B00101010
-#define TM1637_CHAR_X           TM1637_CHAR_H
-#define TM1637_CHAR_Y           B01101110
-#define TM1637_CHAR_Z           B01011011
-#define TM1637_CHAR_L_S_BRACKET B00111001 // 91 (ASCII)
-#define TM1637_CHAR_B_SLASH     B00110000
-#define TM1637_CHAR_R_S_BRACKET B00001111
-#define TM1637_CHAR_A_CIRCUM    B00010011
-#define TM1637_CHAR_UNDERSCORE  B00001000
-#define TM1637_CHAR_A_GRAVE     B00010000
-#define TM1637_CHAR_a           B01011111 // 97 (ASCII)
-#define TM1637_CHAR_b           B01111100
-#define TM1637_CHAR_c           B01011000
-#define TM1637_CHAR_d           B01011110
-#define TM1637_CHAR_e           B01111011
-#define TM1637_CHAR_f           TM1637_CHAR_F
-#define TM1637_CHAR_g           B01101111
-#define TM1637_CHAR_h           B01110100
-#define TM1637_CHAR_i           B00000100
-#define TM1637_CHAR_j           B00001100
-#define TM1637_CHAR_k           TM1637_CHAR_K
-#define TM1637_CHAR_l           B00110000
-#define TM1637_CHAR_m           TM1637_CHAR_M
-#define TM1637_CHAR_n           B01010100
-#define TM1637_CHAR_o           B01011100
-#define TM1637_CHAR_p           TM1637_CHAR_P
-#define TM1637_CHAR_q           TM1637_CHAR_Q
-#define TM1637_CHAR_r           B01010000
-#define TM1637_CHAR_s           TM1637_CHAR_S
-#define TM1637_CHAR_t           B01111000
-#define TM1637_CHAR_u           B00011100
-#define TM1637_CHAR_v           B00011100
-#define TM1637_CHAR_w           TM1637_CHAR_W
-#define TM1637_CHAR_x           TM1637_CHAR_X
-#define TM1637_CHAR_y           B01100110
-#define TM1637_CHAR_z           TM1637_CHAR_Z
-#define TM1637_CHAR_L_ACCON     B01111001 // 123 (ASCII)
-#define TM1637_CHAR_BAR         B00000110
-#define TM1637_CHAR_R_ACCON     B01001111
-#define TM1637_CHAR_TILDE       B01000000 // 126 (ASCII)
+#include "TM1637Font.h"
 
 // debug macros for debugging
 #if TM1637_DEBUG
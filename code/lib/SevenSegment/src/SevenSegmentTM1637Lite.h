@@ -0,0 +1,188 @@
+/*
+  SevenSegmentTM1637Lite - raw segment driver for a TM1637 with the pins fixed at compile time
+
+  A cut down variant of SevenSegmentTM1637 for projects that only push raw segments:
+  no Print inheritance (no vtable, no number formatting), no ASCII table in flash, no
+  cursor or scrolling state. The clock and data pins are template parameters, so every
+  bus edge is a single sbi/cbi instead of a runtime port lookup (see FastGPIO.h).
+
+  The bus protocol and timing (TM1637Bus::halfPeriod) are the same as SevenSegmentTM1637,
+  see the protocol notes in SevenSegmentTM1637.h. Use the TM1637_CHAR_* values to build raw bytes.
+
+  Usage:
+    TM1637<13, 12> display;
+    display.begin();
+    display.printRaw(rawBytes, 4);
+*/
+
+#ifndef SevenSegmentTM1637Lite_H
+#define SevenSegmentTM1637Lite_H
+
+#include <Arduino.h>
+#include "SevenSegmentTM1637.h"
+#include "FastGPIO.h"
+
+template<uint8_t ClkPin, uint8_t DioPin>
+class TM1637 {
+public:
+  typedef FastPin<ClkPin> Clk;
+  typedef FastPin<DioPin> Dio;
+
+  /* Sets up the pins, auto increment mode, clears the display and turns it on
+  */
+  void begin() {
+    Clk::output();
+    Dio::output();
+    Clk::high();
+    Dio::high();
+    _shownValid = false;
+    _control = TM1637_COM_SET_DISPLAY | TM1637_SET_DISPLAY_ON | TM1637_SET_DISPLAY_14;
+    command(TM1637_COM_SET_DATA | TM1637_SET_DATA_WRITE | TM1637_SET_DATA_A_ADDR | TM1537_SET_DATA_M_NORM);
+    clear();
+    sendControl();
+  }
+
+  /* Print raw (binary encoded) bytes to the display, bytes past the last digit are dropped
+  * Only the digits that differ from what the display shows are sent, as one range
+  @param [in] rawBytes      Array of raw bytes
+  @param [in] length        optional: length to print to display
+  @param [in] position      optional: Start position
+  */
+  void printRaw(const uint8_t *rawBytes, uint8_t length = TM1637_MAX_COLOM, uint8_t position = 0) {
+    if (position >= TM1637_MAX_COLOM) {
+      return;
+    }
+    if (length > TM1637_MAX_COLOM - position) {
+      length = TM1637_MAX_COLOM - position;
+    }
+    // narrow the range down to the first and last changed digit
+    uint8_t first = 0;
+    uint8_t last = length;
+    if (_shownValid) {
+      while (first < last && rawBytes[first] == _shown[position + first]) {
+        first++;
+      }
+      while (last > first && rawBytes[last - 1] == _shown[position + last - 1]) {
+        last--;
+      }
+      if (first == last) {
+        return;
+      }
+    }
+
+    comStart();
+    bool acknowledged = comWriteByte(TM1637_COM_SET_ADR | (position + first));
+    for (uint8_t i = first; i < last; i++) {
+      acknowledged &= comWriteByte(rawBytes[i]);
+      _shown[position + i] = rawBytes[i];
+    }
+    comStop();
+    // the display may hold anything now, send everything next time
+    _shownValid = acknowledged && (_shownValid || (position == 0 && length == TM1637_MAX_COLOM));
+  }
+
+  /* Print a single raw byte
+  @param [in] rawByte       Raw byte
+  @param [in] position      Position (digit)
+  */
+  void printRaw(uint8_t rawByte, uint8_t position) {
+    printRaw(&rawByte, 1, position);
+  }
+
+  /* Writes zero to all digits
+  */
+  void clear() {
+    const uint8_t blank[TM1637_MAX_COLOM] = {0, };
+    printRaw(blank);
+  }
+
+  /* Sets the display brightness, same scale as SevenSegmentTM1637::setBacklight()
+  * Only the display control command is sent, the digits stay in the display RAM
+  @param [in] value         brightness value (0..80(100)), 0 turns the display off
+  */
+  void setBacklight(uint8_t value) {
+    value = value > 100 ? 100 : value;
+    value /= 10;
+    value = value > 8 ? 8 : value;
+    // levels 1..8 map to the pulse widths 0..7, level 0 keeps the last width for on()
+    if (value > 0) {
+      _control = TM1637_COM_SET_DISPLAY | TM1637_SET_DISPLAY_ON | (value - 1);
+    } else {
+      _control &= ~TM1637_SET_DISPLAY_ON;
+    }
+    sendControl();
+  }
+
+  /* Switches the display on at the last brightness, or off, without touching the digits
+  */
+  void on()  { _control |= TM1637_SET_DISPLAY_ON; sendControl(); }
+  void off() { _control &= ~TM1637_SET_DISPLAY_ON; sendControl(); }
+
+  /* Write a single byte command
+  @return acknowledged?     command was (successful) acknowledged
+  */
+  bool command(uint8_t cmd) {
+    comStart();
+    bool acknowledged = comWriteByte(cmd);
+    comStop();
+    return acknowledged;
+  }
+
+private:
+  static void comStart() {
+    Dio::high();
+    Clk::high();
+    delayMicroseconds(TM1637Bus::halfPeriod);
+    Dio::low();
+  }
+
+  // Sends a byte and clocks in its acknowledge
+  static bool comWriteByte(uint8_t value) {
+    for (uint8_t i = 0; i < 8; i++) {
+      Clk::low();
+      Dio::write(value & 0x01);
+      delayMicroseconds(TM1637Bus::halfPeriod);
+      value >>= 1;
+      Clk::high();
+      delayMicroseconds(TM1637Bus::halfPeriod);
+    }
+    return comAck();
+  }
+
+  static bool comAck() {
+    Clk::low();
+    Dio::inputPullUp();
+    delayMicroseconds(TM1637Bus::halfPeriod);
+    bool acknowledged = !Dio::read();
+    Clk::high();
+    delayMicroseconds(TM1637Bus::halfPeriod);
+    Clk::low();
+    Dio::output();
+    TM1637Bus::record(acknowledged);
+    return acknowledged;
+  }
+
+  static void comStop() {
+    Clk::low();
+    delayMicroseconds(TM1637Bus::halfPeriod);
+    Dio::low();
+    delayMicroseconds(TM1637Bus::halfPeriod);
+    Clk::high();
+    delayMicroseconds(TM1637Bus::halfPeriod);
+    Dio::high();
+  }
+
+  // Sends the display control byte unless the display already has it
+  void sendControl() {
+    if (_control != _sentControl) {
+      _sentControl = command(_control) ? _control : 0;
+    }
+  }
+
+  uint8_t _shown[TM1637_MAX_COLOM];   // what the display RAM holds
+  bool    _shownValid;                // false until a full write was acknowledged
+  uint8_t _control;                   // display control byte (on bit and pulse width)
+  uint8_t _sentControl;               // last acknowledged control byte, 0 if unknown
+};
+
+#endif
@@ -0,0 +1,90 @@
+/*
+  TM1637Calibration - finds the fastest reliable bus timing of a TM1637 at runtime
+
+  TM1637_CLK_DELAY_US is a safe guess, most displays acknowledge at a much shorter
+  half clock period. calibrate() steps TM1637Bus::halfPeriod down from the default and
+  sends harmless data set commands at every step, until the first one is not
+  acknowledged. The shortest period that passed every probe plus a margin is kept.
+
+  check() watches the acknowledge counters afterwards and calibrates again, slower
+  than before, once too many transfers fail (a warm display, a long cable, ...).
+
+  Works with SevenSegmentTM1637 and TM1637<Clk, Dio>, both provide command().
+
+  Usage:
+    display.begin();
+    tm1637Calibrate(display);
+    ...
+    tm1637Check(display);   // every now and then
+*/
+
+#ifndef TM1637Calibration_H
+#define TM1637Calibration_H
+
+#include <Arduino.h>
+#include "SevenSegmentTM1637.h"
+
+#define TM1637_CALIBRATION_PROBES       8     // commands that must pass at every step
+#define TM1637_CALIBRATION_MARGIN       1     // us added to the shortest period that passed
+#define TM1637_CHECK_TRANSFERS          64    // acknowledges before the failure rate is judged
+#define TM1637_CHECK_FAILURE_SHIFT      4     // recalibrate above 1 failure in 2^shift transfers
+
+// Resending the data set command changes nothing on the display
+const uint8_t tm1637ProbeCommand = TM1637_COM_SET_DATA | TM1637_SET_DATA_WRITE | TM1637_SET_DATA_A_ADDR | TM1537_SET_DATA_M_NORM;
+
+/* Sets TM1637Bus::halfPeriod to the shortest working period plus margin
+@param [in] display       display to probe, must be begun
+@param [in] slowest       period to start from (us), kept if even that one fails
+@param [in] margin        optional: us added to the shortest working period
+@return calibrated?       false if the display did not acknowledge at all
+*/
+template<class Display>
+bool tm1637Calibrate(Display &display, uint8_t slowest = TM1637_CLK_DELAY_US, uint8_t margin = TM1637_CALIBRATION_MARGIN) {
+  int8_t shortest = -1;
+  for (int8_t period = slowest; period >= 0; period--) {
+    TM1637Bus::halfPeriod = period;
+    bool passed = true;
+    for (uint8_t i = 0; i < TM1637_CALIBRATION_PROBES && passed; i++) {
+      passed = display.command(tm1637ProbeCommand);
+    }
+    if (!passed) {
+      break;
+    }
+    shortest = period;
+  }
+
+  if (shortest < 0) {
+    TM1637Bus::halfPeriod = slowest;
+  } else {
+    uint8_t period = shortest + margin;
+    TM1637Bus::halfPeriod = period > slowest ? slowest : period;
+  }
+  // the failed probes may have left the chip in a bad state, talk to it once at the chosen speed
+  display.command(tm1637ProbeCommand);
+  TM1637Bus::resetCounters();
+  return shortest >= 0;
+}
+
+/* Calibrates again, never faster than now, if the failure rate went up
+@param [in] display       display to probe
+@return recalibrated?     the period was changed
+*/
+template<class Display>
+bool tm1637Check(Display &display) {
+  if (TM1637Bus::transfers < TM1637_CHECK_TRANSFERS) {
+    return false;
+  }
+  bool failing = TM1637Bus::failures > (TM1637Bus::transfers >> TM1637_CHECK_FAILURE_SHIFT);
+  if (!failing) {
+    TM1637Bus::resetCounters();
+    return false;
+  }
+  uint8_t previous = TM1637Bus::halfPeriod;
+  if (!tm1637Calibrate(display) || TM1637Bus::halfPeriod <= previous) {
+    // no display or the same result again, back off one step instead
+    TM1637Bus::halfPeriod = previous < TM1637_CLK_DELAY_US ? previous + 1 : TM1637_CLK_DELAY_US;
+  }
+  return TM1637Bus::halfPeriod != previous;
+}
+
+#endif
@@ -0,0 +1,37 @@
+#include <Arduino.h>
+#include "ArduinoNative.h"
+#include "CoinValidatorModel.h"
+
+CoinValidatorModel::CoinValidatorModel(uint8_t pin, uint16_t centsPerPulse, uint64_t pulseLength,
+                                       uint64_t pulseSpace, uint64_t coinSpace) :
+  _pin(pin), _centsPerPulse(centsPerPulse), _pulseLength(pulseLength), _pulseSpace(pulseSpace),
+  _coinSpace(coinSpace), _coin(0), _pulses(0), _low(false), _next(0), _inserted(0) {
+}
+
+void CoinValidatorModel::update(uint64_t now) {
+  if (now < _next) {
+    return;
+  }
+  if (_low) {
+    nativeReleaseInput(_pin);
+    _low = false;
+    if (--_pulses > 0) {
+      _next = now + _pulseSpace;
+    } else {
+      _inserted += _coin;
+      _next = now + _coinSpace;
+    }
+  } else if (_pulses > 0 || !_queue.empty()) {
+    if (_pulses == 0) {
+      _coin = _queue.front();
+      _queue.pop_front();
+      _pulses = _coin / _centsPerPulse;
+      if (_pulses == 0) {
+        return;
+      }
+    }
+    nativeSetInput(_pin, LOW);
+    _low = true;
+    _next = now + _pulseLength;
+  }
+}
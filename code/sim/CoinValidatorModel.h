@@ -0,0 +1,42 @@
+#ifndef COIN_VALIDATOR_MODEL_H
+#define COIN_VALIDATOR_MODEL_H
+
+#include <stdint.h>
+#include <deque>
+
+/*
+A pulse output coin validator on one input pin: every coin becomes a train of pulses
+(the pin pulled low pulseLength us, released pulseSpace us), one pulse per
+centsPerPulse cents, the next coin follows coinSpace us after the last pulse.
+insert() queues coins, so a player can feed several back to back; update() drives
+the pin and must be called every loop.
+
+The defaults fit the firmware defaults (coinPulseMin/Max, coinTrainGap, coinPulseValue
+in Config.h): 50 ms pulses, 50 ms apart, 300 ms between coins.
+*/
+
+class CoinValidatorModel {
+public:
+  CoinValidatorModel(uint8_t pin, uint16_t centsPerPulse = 50, uint64_t pulseLength = 50000,
+                     uint64_t pulseSpace = 50000, uint64_t coinSpace = 300000);
+
+  void    insert(uint16_t cents) { _queue.push_back(cents); }
+  void    update(uint64_t now);
+
+  bool    isBusy() const { return _pulses > 0 || !_queue.empty(); }
+  // Cents of every coin sent completely
+  long    inserted() const { return _inserted; }
+
+private:
+  uint8_t  _pin;
+  uint16_t _centsPerPulse;
+  uint64_t _pulseLength, _pulseSpace, _coinSpace;
+  std::deque<uint16_t> _queue;
+  uint16_t _coin;           // cents of the coin being sent
+  uint8_t  _pulses;         // pulses of it still to send
+  bool     _low;
+  uint64_t _next;           // next level change
+  long     _inserted;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include <inttypes.h>
+#include <string.h>
+#include "FrameTrace.h"
+
+static const char traceMagic[4] = {'S', 'I', 'M', 'T'};
+
+FrameTrace::FrameTrace() :
+  _file(NULL), _writing(false), _registers(0), _lastTime(0), _goldenTime(0),
+  _frames(0), _bytes(0), _diverged(false) {
+  _seen[0] = _seen[1] = false;
+}
+
+bool FrameTrace::record(const char *path, uint8_t registers) {
+  _file = fopen(path, "wb");
+  if (_file == NULL) {
+    perror(path);
+    return false;
+  }
+  _writing = true;
+  _registers = registers;
+  fwrite(traceMagic, 1, sizeof(traceMagic), _file);
+  fputc(FRAME_TRACE_VERSION, _file);
+  fputc(registers, _file);
+  _bytes = sizeof(traceMagic) + 2;
+  return true;
+}
+
+bool FrameTrace::compare(const char *path, uint8_t registers) {
+  _file = fopen(path, "rb");
+  if (_file == NULL) {
+    perror(path);
+    return false;
+  }
+  char magic[sizeof(traceMagic)];
+  if (fread(magic, 1, sizeof(magic), _file) != sizeof(magic) ||
+      memcmp(magic, traceMagic, sizeof(magic)) != 0 ||
+      fgetc(_file) != FRAME_TRACE_VERSION) {
+    fprintf(stderr, "%s: not a frame trace of version %d\n", path, FRAME_TRACE_VERSION);
+    return false;
+  }
+  int golden = fgetc(_file);
+  if (golden != registers) {
+    fprintf(stderr, "%s: recorded with %d registers, this build has %u\n", path, golden, registers);
+    return false;
+  }
+  _registers = registers;
+  return true;
+}
+
+bool FrameTrace::close() {
+  if (_file == NULL) {
+    return true;
+  }
+  bool ok = !_writing || (!ferror(_file));
+  ok &= fclose(_file) == 0;
+  _file = NULL;
+  return ok;
+}
+
+uint8_t FrameTrace::length(uint8_t kind) const {
+  return kind == FRAME_REELS ? _registers : 5;
+}
+
+bool FrameTrace::add(uint8_t kind, uint64_t time, const uint8_t *data, uint8_t length) {
+  uint8_t slot = kind == FRAME_REELS ? 0 : 1;
+  if (_file == NULL || _diverged || (_seen[slot] && memcmp(_last[slot], data, length) == 0)) {
+    return !_diverged;
+  }
+  memcpy(_last[slot], data, length);
+  _seen[slot] = true;
+
+  Frame frame;
+  frame.kind = kind;
+  frame.time = time;
+  frame.length = length;
+  memcpy(frame.data, data, length);
+
+  if (_writing) {
+    fputc(kind, _file);
+    uint64_t delta = time - _lastTime;
+    do {
+      fputc((delta & 0x7F) | (delta > 0x7F ? 0x80 : 0), _file);
+      delta >>= 7;
+      _bytes++;
+    } while (delta != 0);
+    fwrite(data, 1, length, _file);
+    _bytes += 1 + length;
+  } else {
+    Frame expected;
+    if (!read(expected)) {
+      fprintf(stderr, "frame %lu: the golden trace ends here\n", _frames);
+      print("got", frame);
+      _diverged = true;
+    } else if (expected.kind != kind || expected.time != time ||
+               memcmp(expected.data, data, length) != 0) {
+      fprintf(stderr, "frame %lu differs from the golden trace\n", _frames);
+      print("expected", expected);
+      print("got", frame);
+      _diverged = true;
+    }
+  }
+  _lastTime = time;
+  _frames++;
+  return !_diverged;
+}
+
+bool FrameTrace::complete() const {
+  if (_file == NULL || _writing || _diverged) {
+    return !_diverged;
+  }
+  int next = fgetc(_file);
+  if (next != EOF) {
+    fprintf(stderr, "frame %lu: the golden trace goes on, this run stopped\n", _frames);
+    return false;
+  }
+  return true;
+}
+
+bool FrameTrace::read(Frame &frame) {
+  int kind = fgetc(_file);
+  if (kind != FRAME_REELS && kind != FRAME_BALANCE) {
+    return false;
+  }
+  uint64_t delta = 0;
+  int shift = 0;
+  int value;
+  do {
+    value = fgetc(_file);
+    if (value == EOF || shift > 63) {
+      return false;
+    }
+    delta |= (uint64_t)(value & 0x7F) << shift;
+    shift += 7;
+  } while (value & 0x80);
+  frame.kind = kind;
+  frame.length = length(kind);
+  _goldenTime += delta;
+  frame.time = _goldenTime;
+  return fread(frame.data, 1, frame.length, _file) == frame.length;
+}
+
+void FrameTrace::print(const char *label, const Frame &frame) const {
+  fprintf(stderr, "  %-8s %s at %" PRIu64 " us:", label,
+          frame.kind == FRAME_REELS ? "reels  " : "balance", frame.time);
+  for (uint8_t i = 0; i < frame.length; i++) {
+    fprintf(stderr, " %02X", frame.data[i]);
+  }
+  fputc('\n', stderr);
+}
@@ -0,0 +1,66 @@
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+/*
+Every frame the displays showed during a simulator run, as a compact binary file:
+  'S' 'I' 'M' 'T'  version  registers
+followed by one record per frame that differs from the previous one of its kind:
+  kind  time delta in us (LEB128)  data
+Kind FRAME_REELS carries the latched byte of every register (0 while /OE is high),
+FRAME_BALANCE the four TM1637 digits and its display control byte.
+
+In compare mode a trace is checked against a recorded (golden) one while it is
+produced, and stops at the first frame that differs.
+*/
+
+#define FRAME_TRACE_VERSION  1
+#define FRAME_REELS          'R'
+#define FRAME_BALANCE        'D'
+#define FRAME_MAX_DATA       16
+
+class FrameTrace {
+public:
+  FrameTrace();
+
+  bool    record(const char *path, uint8_t registers);
+  bool    compare(const char *path, uint8_t registers);
+  // Writes the recording, false if that failed
+  bool    close();
+
+  // Adds a frame unless it repeats the last one of its kind, false on a divergence
+  bool    add(uint8_t kind, uint64_t time, const uint8_t *data, uint8_t length);
+  // Frames the golden trace has that this run did not produce
+  bool    complete() const;
+
+  unsigned long frames() const { return _frames; }
+  unsigned long bytes() const { return _bytes; }
+  bool    diverged() const { return _diverged; }
+
+private:
+  struct Frame {
+    uint8_t  kind;
+    uint64_t time;
+    uint8_t  data[FRAME_MAX_DATA];
+    uint8_t  length;
+  };
+
+  uint8_t length(uint8_t kind) const;
+  bool    read(Frame &frame);
+  void    print(const char *label, const Frame &frame) const;
+
+  FILE   *_file;
+  bool    _writing;
+  uint8_t _registers;
+  uint8_t _last[2][FRAME_MAX_DATA];
+  bool    _seen[2];
+  uint64_t _lastTime;     // of the previous record, for the deltas
+  uint64_t _goldenTime;
+  unsigned long _frames, _bytes;
+  bool    _diverged;
+};
+
+#endif
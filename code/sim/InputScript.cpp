@@ -0,0 +1,107 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "InputScript.h"
+#include "Wiring.h"
+
+struct InputName {
+  const char *name;
+  uint8_t     pin;
+  uint16_t    cents;
+};
+
+static const InputName inputNames[] = {
+  {"trigger",  triggerPin,    0},
+  {"coin50",   fivetyCentPin, 0},
+  {"coin100",  oneEuroPin,    0},
+  {"coin200",  twoEurosPin,   0},
+  {"pulse50",  coinPulsePin,  50},
+  {"pulse100", coinPulsePin,  100},
+  {"pulse200", coinPulsePin,  200},
+};
+static const uint8_t inputCount = sizeof(inputNames) / sizeof(inputNames[0]);
+
+InputScript::InputScript() : seed(0), loopTime(0), turbo(false), end(0) {
+}
+
+bool InputScript::load(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  char line[128];
+  unsigned number = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), file) != NULL) {
+    number++;
+    char *comment = strchr(line, '#');
+    if (comment != NULL) {
+      *comment = '\0';
+    }
+    char word[16];
+    uint64_t value;
+    uint64_t length = 0;
+    int fields = sscanf(line, "%" SCNu64 " %15s %" SCNu64, &value, word, &length);
+    if (fields >= 2) {
+      uint8_t i = 0;
+      while (i < inputCount && strcmp(word, inputNames[i].name) != 0) {
+        i++;
+      }
+      ok = i < inputCount && (events.empty() || events.back().at <= value) &&
+           (length == 0 || inputNames[i].cents == 0);
+      if (ok) {
+        add(value, inputNames[i].pin, inputNames[i].cents, length);
+      }
+    } else if (sscanf(line, "%15s", word) == 1) {
+      if (strcmp(word, "turbo") == 0) {
+        turbo = true;
+      } else if (strcmp(word, "seed") == 0) {
+        ok = sscanf(line, "%*s %lu", &seed) == 1;
+      } else if (strcmp(word, "loop-us") == 0) {
+        ok = sscanf(line, "%*s %" SCNu64, &loopTime) == 1 && loopTime > 0;
+      } else if (strcmp(word, "end") == 0) {
+        ok = sscanf(line, "%*s %" SCNu64, &end) == 1;
+      } else {
+        ok = false;
+      }
+    }
+  }
+  fclose(file);
+  if (!ok) {
+    fprintf(stderr, "%s:%u: not a script line: %s", path, number, line);
+  }
+  return ok;
+}
+
+bool InputScript::save(const char *path) const {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  fprintf(file, "seed %lu\n", seed);
+  if (loopTime != 0) {
+    fprintf(file, "loop-us %" PRIu64 "\n", loopTime);
+  }
+  if (turbo) {
+    fprintf(file, "turbo\n");
+  }
+  for (size_t i = 0; i < events.size(); i++) {
+    const char *name = "?";
+    for (uint8_t j = 0; j < inputCount; j++) {
+      if (inputNames[j].pin == events[i].pin && inputNames[j].cents == events[i].cents) {
+        name = inputNames[j].name;
+      }
+    }
+    if (events[i].length != 0) {
+      fprintf(file, "%" PRIu64 " %s %" PRIu64 "\n", events[i].at, name, events[i].length);
+    } else {
+      fprintf(file, "%" PRIu64 " %s\n", events[i].at, name);
+    }
+  }
+  if (end != 0) {
+    fprintf(file, "end %" PRIu64 "\n", end);
+  }
+  return fclose(file) == 0;
+}
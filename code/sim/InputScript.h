@@ -0,0 +1,51 @@
+#ifndef INPUT_SCRIPT_H
+#define INPUT_SCRIPT_H
+
+#include <stdint.h>
+#include <vector>
+
+/*
+The buttons and coins of one simulator run, so it can be played again exactly.
+
+Text, one entry per line, '#' starts a comment:
+  seed 1234           randomSeed() before setup()
+  loop-us 1000        virtual time per loop() call
+  turbo               short spin and wait times after setup() (see Simulator.cpp)
+  12000000 trigger    press at virtual time 12 s (in us): trigger, coin50, coin100, coin200
+  13000000 pulse200   a coin into the pulse validator: pulse50, pulse100, pulse200
+  14000000 trigger 2000000   a button held down for 2 s instead of a short press
+  end 60000000        stop the run at this virtual time
+
+On the host the firmware seeds its outcome generator from random() at boot and mixes
+in the start time of every round, so the seed and the press times decide the outcomes
+and a replay only depends on the script.
+*/
+
+struct InputEvent {
+  uint64_t at;      // virtual time in us
+  uint8_t  pin;
+  uint16_t cents;   // coin into the validator on pin, 0 for a button press
+  uint64_t length;  // us the button is held, 0 for a short press
+};
+
+class InputScript {
+public:
+  InputScript();
+
+  // Returns false and prints the offending line if the file is not a script
+  bool    load(const char *path);
+  bool    save(const char *path) const;
+
+  void    add(uint64_t at, uint8_t pin, uint16_t cents = 0, uint64_t length = 0) {
+    InputEvent event = {at, pin, cents, length};
+    events.push_back(event);
+  }
+
+  unsigned long seed;
+  uint64_t loopTime;    // 0 keeps the command line value
+  bool     turbo;
+  uint64_t end;         // 0 runs until the command line duration
+  std::vector<InputEvent> events;
+};
+
+#endif
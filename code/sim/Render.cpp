@@ -0,0 +1,101 @@
+#include <string.h>
+#include "Render.h"
+#include "Wiring.h"
+#include "TM1637Font.h"
+
+// Segments in one order for both displays
+struct Segments {
+  bool top, upperLeft, upperRight, middle, lowerLeft, lowerRight, bottom, dot;
+};
+
+// Reel digits, bit order from left to right as in GameCore.cpp
+static Segments reelSegments(uint8_t value) {
+  Segments s = {
+    (value & 0x80) != 0, (value & 0x40) != 0, (value & 0x20) != 0, (value & 0x10) != 0,
+    (value & 0x04) != 0, (value & 0x08) != 0, (value & 0x02) != 0, (value & 0x01) != 0
+  };
+  return s;
+}
+
+// TM1637: bit 0 is segment A (top), then clockwise, G (middle) and the colon/dot
+static Segments balanceSegments(uint8_t value) {
+  Segments s = {
+    (value & 0x01) != 0, (value & 0x20) != 0, (value & 0x02) != 0, (value & 0x40) != 0,
+    (value & 0x10) != 0, (value & 0x04) != 0, (value & 0x08) != 0, (value & 0x80) != 0
+  };
+  return s;
+}
+
+// Appends text line 0..2 of a digit, 4 columns wide
+static void drawDigit(char *line, uint8_t row, const Segments &s) {
+  char cell[5];
+  switch (row) {
+    case 0:
+      snprintf(cell, sizeof(cell), " %c  ", s.top ? '_' : ' ');
+      break;
+    case 1:
+      snprintf(cell, sizeof(cell), "%c%c%c ", s.upperLeft ? '|' : ' ', s.middle ? '_' : ' ', s.upperRight ? '|' : ' ');
+      break;
+    default:
+      snprintf(cell, sizeof(cell), "%c%c%c%c", s.lowerLeft ? '|' : ' ', s.bottom ? '_' : ' ', s.lowerRight ? '|' : ' ', s.dot ? '.' : ' ');
+      break;
+  }
+  strcat(line, cell);
+}
+
+void renderFrame(FILE *out, const ShiftRegisterModel &reels, const Tm1637Model &balance, const char *status) {
+  fprintf(out, "%s\n", status);
+  for (uint8_t row = 0; row < Geometry::rows; row++) {
+    for (uint8_t text = 0; text < 3; text++) {
+      char line[128] = "  ";
+      for (uint8_t reel = 0; reel < Geometry::reels; reel++) {
+        drawDigit(line, text, reelSegments(reels.output(segmentOrder[row][reel])));
+      }
+      if (row == 0) {
+        strcat(line, "     ");
+        for (uint8_t i = 0; i < 4; i++) {
+          drawDigit(line, text, balanceSegments(balance.isOn() ? balance.digit(i) : 0));
+        }
+      } else if (row == 1 && text == 1) {
+        char info[32];
+        snprintf(info, sizeof(info), "     %s %u/8", balance.isOn() ? "on" : "off", balance.brightness());
+        strcat(line, info);
+      }
+      fprintf(out, "%s\n", line);
+    }
+  }
+}
+
+bool readBalance(const Tm1637Model &balance, long &cents) {
+  static const uint8_t digits[10] = {
+    TM1637_CHAR_0, TM1637_CHAR_1, TM1637_CHAR_2, TM1637_CHAR_3, TM1637_CHAR_4,
+    TM1637_CHAR_5, TM1637_CHAR_6, TM1637_CHAR_7, TM1637_CHAR_8, TM1637_CHAR_9,
+  };
+  bool negative = false;
+  bool started = false;
+  cents = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    uint8_t value = balance.digit(i);
+    if (value == 0 && !started) {
+      continue;
+    }
+    if (value == TM1637_CHAR_MIN && !started) {
+      negative = true;
+      started = true;
+      continue;
+    }
+    uint8_t digit = 0;
+    while (digit < 10 && digits[digit] != value) {
+      digit++;
+    }
+    if (digit == 10) {
+      return false;
+    }
+    cents = cents * 10 + digit;
+    started = true;
+  }
+  if (negative) {
+    cents = -cents;
+  }
+  return started;
+}
@@ -0,0 +1,15 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdio.h>
+#include "ShiftRegisterModel.h"
+#include "Tm1637Model.h"
+
+// Draws the reel digits (in their rows and reels, see Wiring.h) and the balance
+// display as seven segment ASCII art, below a status line
+void renderFrame(FILE *out, const ShiftRegisterModel &reels, const Tm1637Model &balance, const char *status);
+
+// Value the balance display shows in cents, false if it shows anything but a number
+bool readBalance(const Tm1637Model &balance, long &cents);
+
+#endif
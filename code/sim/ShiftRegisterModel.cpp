@@ -0,0 +1,45 @@
+#include "ShiftRegisterModel.h"
+
+ShiftRegisterModel::ShiftRegisterModel(uint8_t dataPin, uint8_t clockPin, uint8_t latchPin, uint8_t enablePin, uint8_t length) :
+  _dataPin(dataPin), _clockPin(clockPin), _latchPin(latchPin), _enablePin(enablePin),
+  _length(length > SHIFT_REGISTER_MODEL_MAX ? SHIFT_REGISTER_MODEL_MAX : length),
+  _dataLevel(0), _clockLevel(0), _latchLevel(0), _enableLevel(0), _latches(0) {
+  for (uint8_t i = 0; i < SHIFT_REGISTER_MODEL_MAX; i++) {
+    _shift[i] = 0;
+    _latched[i] = 0;
+  }
+}
+
+void ShiftRegisterModel::onPin(uint8_t pin, uint8_t level) {
+  if (pin == _dataPin) {
+    _dataLevel = level;
+  } else if (pin == _enablePin) {
+    _enableLevel = level;
+  } else if (pin == _clockPin) {
+    if (level && !_clockLevel) {
+      // bit 0 of each register moves into bit 7 of the next one down the chain
+      uint8_t carry = _dataLevel ? 0x80 : 0;
+      for (uint8_t r = 0; r < _length; r++) {
+        uint8_t out = (_shift[r] & 0x01) ? 0x80 : 0;
+        _shift[r] = (_shift[r] >> 1) | carry;
+        carry = out;
+      }
+    }
+    _clockLevel = level;
+  } else if (pin == _latchPin) {
+    if (level && !_latchLevel) {
+      for (uint8_t r = 0; r < _length; r++) {
+        _latched[r] = _shift[r];
+      }
+      _latches++;
+    }
+    _latchLevel = level;
+  }
+}
+
+uint8_t ShiftRegisterModel::output(uint8_t i) const {
+  if (i >= _length || _enableLevel) {
+    return 0;
+  }
+  return _latched[_length - 1 - i];
+}
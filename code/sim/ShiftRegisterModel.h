@@ -0,0 +1,39 @@
+#ifndef SHIFT_REGISTER_MODEL_H
+#define SHIFT_REGISTER_MODEL_H
+
+#include <stdint.h>
+
+/*
+A chain of 74HC595 registers as the firmware sees it, rebuilt from the level changes
+of the data, clock, latch and /OE pins (feed every change to onPin()).
+
+Every rising clock edge shifts the data pin into the register next to the Arduino and
+moves the others one bit further down the chain, a rising latch edge copies them to
+the outputs. output(i) is numbered like the buffer the firmware shifts out, so byte 0
+is the register furthest from the Arduino.
+*/
+
+#define SHIFT_REGISTER_MODEL_MAX 16
+
+class ShiftRegisterModel {
+public:
+  ShiftRegisterModel(uint8_t dataPin, uint8_t clockPin, uint8_t latchPin, uint8_t enablePin, uint8_t length);
+
+  void    onPin(uint8_t pin, uint8_t level);
+
+  uint8_t length() const { return _length; }
+  // Latched segments of register i, 0 while /OE is high
+  uint8_t output(uint8_t i) const;
+  bool    isEnabled() const { return !_enableLevel; }
+  // Latch pulses since the start, to see whether anything was sent
+  unsigned long latches() const { return _latches; }
+
+private:
+  uint8_t _dataPin, _clockPin, _latchPin, _enablePin, _length;
+  uint8_t _dataLevel, _clockLevel, _latchLevel, _enableLevel;
+  uint8_t _shift[SHIFT_REGISTER_MODEL_MAX];   // [0] is next to the Arduino
+  uint8_t _latched[SHIFT_REGISTER_MODEL_MAX];
+  unsigned long _latches;
+};
+
+#endif
@@ -0,0 +1,521 @@
+/*
+  Terminal simulator: runs the firmware under virtual time, rebuilds the reel digits
+  from the 74HC595 pins and the balance display from the TM1637 pins and draws them.
+
+  sim [--speed x] [--duration ms] [--loop-us us] [--rounds n] [--turbo] [--quiet]
+      [--coin-pulses] [--queue | --autoplay | --quick-stop] [--idle ms] [--eeprom file] [--boot us] [--script file]
+      [--save-script file] [--record trace | --compare trace]
+
+  --speed 1 (default) runs in real time, 0 as fast as possible, 0.1 ten times slower.
+  --rounds n lets a player insert coins and pull the trigger until n rounds are over,
+  then checks that the balance on the display matches coins, stakes and payouts
+  (exit code 1 if not). --turbo shortens frameTime, spinTime, waitBeforeIdle and
+  blinkTime and lets the reels land faster after boot, so rounds take about a second
+  of virtual time. Frames are
+  drawn on every change, at most every 50 ms of virtual time, unless --quiet.
+  --coin-pulses makes the player use the pulse validator (see CoinValidatorModel.h)
+  instead of the coin buttons, also during spins while the balance is low; the
+  summary then also checks that every coin was credited. --queue makes the player press
+  the trigger once more during each round, so the next one follows on its own (quick
+  stops off, turbo rounds spin 1.5 s); the summary fails unless every such press
+  started a paid round. With --autoplay the player holds the trigger to start autoplay
+  runs instead. The summary counts the games per hour of virtual time. --quick-stop presses the trigger again
+  while the reels speed up or spin; the summary adds the time from that press to the
+  payout and fails if it ever took longer than quickStopTime. --idle ms makes the player
+  leave the machine idle for that long after half the rounds; loops then run once per
+  second of virtual time. A gap longer than 2^31 ms checks that the presses after it
+  still count. The summary fails unless all rounds were played.
+
+  --script plays the presses of an input script (see InputScript.h) instead, and
+  --save-script writes the presses of this run as one. --record writes every reel and
+  balance frame to a trace (see FrameTrace.h), --compare checks them against a trace
+  recorded earlier and exits with 1 at the first frame that differs. sim/golden holds
+  the pair CI replays:
+
+    sim --rounds 100 --turbo --speed 0 --quiet --save-script sim/golden/rounds.txt --record sim/golden/rounds.trace
+    sim --script sim/golden/rounds.txt --speed 0 --quiet --compare sim/golden/rounds.trace
+*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "ArduinoNative.h"
+#include "Config.h"
+#include "ReelGeometry.h"
+#include "Wiring.h"
+#include "FrameTrace.h"
+#include "CoinValidatorModel.h"
+#include "InputScript.h"
+#include "Render.h"
+#include "ShiftRegisterModel.h"
+#include "TelemetryReader.h"
+#include "Tm1637Model.h"
+
+extern void setup(void);
+extern void loop(void);
+
+// mirrors the firmware, see GameCore.h
+static const long spinCost = 100;
+static const uint8_t stateSpinup = 3;
+static const char *const stateNames[] = {
+  "OFF", "IDLE", "START_SPINNING", "SPINUP", "SPINNING", "SPINDOWN", "WAITING"
+};
+static const char *const outcomeNames[] = {"HTOP", "HMID", "HBOT", "DTL", "DTR", "NONE"};
+static const uint8_t outcomeCount = sizeof(outcomeNames) / sizeof(outcomeNames[0]);
+
+// time between two presses, the firmware ignores presses for 1 s after each one
+static const uint64_t pressInterval = 1100000;
+static const uint64_t pressLength = 20000;
+// long enough to start autoplay (GameCore::autoplayHold)
+static const uint64_t holdLength = 2000000;
+// virtual time per loop while the player is away (--idle)
+static const uint64_t idleLoopTime = 1000000;
+static const uint64_t frameInterval = 50000;
+
+static ShiftRegisterModel reels(dataPin, clockPin, latchPin, outputEnablePin, registerCount);
+static Tm1637Model balanceDisplay(balanceClock, balanceData);
+static CoinValidatorModel validator(coinPulsePin);
+static TelemetryReader reader;
+static FrameTrace trace;
+
+// what the player saw on the serial line
+static uint8_t state = 0;
+static unsigned long rounds = 0;
+static unsigned long spins = 0;
+static long coins = 0;
+static long payouts = 0;
+static long reportedBalance = 0;
+static bool ledgerBroken = false;
+static unsigned long outcomes[outcomeCount];
+static bool changed = true;
+static bool coinPulses = false;
+static bool queueSpins = false;
+static bool autoplay = false;
+static bool quickStops = false;
+// queue presses of the player, and rounds that started without a press of their own
+static unsigned long queuePresses = 0;
+static unsigned long queuedStarts = 0;
+static bool startPressed = false;
+// quick stop press of the current round, 0 if there was none
+static uint64_t quickStopAt = 0;
+static unsigned long quickStopCount = 0;
+static uint64_t quickStopTotal = 0;
+static uint64_t quickStopWorst = 0;
+
+static void onPin(uint8_t pin, uint8_t level, uint64_t micros) {
+  reels.onPin(pin, level);
+  balanceDisplay.onPin(pin, level, micros);
+  changed = true;
+
+  uint8_t frame[FRAME_MAX_DATA];
+  if (pin == latchPin || pin == outputEnablePin) {
+    for (uint8_t i = 0; i < registerCount; i++) {
+      frame[i] = reels.output(i);
+    }
+    trace.add(FRAME_REELS, micros, frame, registerCount);
+  } else if (pin == balanceClock || pin == balanceData) {
+    for (uint8_t i = 0; i < 4; i++) {
+      frame[i] = balanceDisplay.digit(i);
+    }
+    frame[4] = balanceDisplay.control();
+    trace.add(FRAME_BALANCE, micros, frame, 5);
+  }
+}
+
+static long payloadWord(const TelemetryPacket &packet, uint8_t offset) {
+  return (int16_t)(packet.payload[offset] | (packet.payload[offset + 1] << 8));
+}
+
+static long payloadLong(const TelemetryPacket &packet, uint8_t offset) {
+  return (int32_t)(((uint32_t)payloadWord(packet, offset) & 0xFFFF) |
+                   ((uint32_t)payloadWord(packet, offset + 2) << 16));
+}
+
+static void onSerial(uint8_t value) {
+  if (!reader.feed(value)) {
+    return;
+  }
+  const TelemetryPacket &packet = reader.packet();
+  switch (packet.type) {
+    case TELEMETRY_STATE:
+      state = packet.payload[0];
+      if (state == stateSpinup) {
+        spins++;
+        if (!startPressed) {
+          queuedStarts++;
+        }
+        startPressed = false;
+      }
+      break;
+    case TELEMETRY_OUTCOME:
+      if (packet.payload[0] < outcomeCount) {
+        outcomes[packet.payload[0]]++;
+      }
+      break;
+    case TELEMETRY_COIN:
+      coins += (uint16_t)payloadWord(packet, 0);
+      reportedBalance = payloadLong(packet, 2);
+      break;
+    case TELEMETRY_ROUND_OVER:
+      rounds++;
+      if (quickStopAt != 0) {
+        uint64_t latency = nativeNow() - quickStopAt;
+        quickStopCount++;
+        quickStopTotal += latency;
+        quickStopWorst = latency > quickStopWorst ? latency : quickStopWorst;
+        quickStopAt = 0;
+      }
+      payouts += (uint16_t)payloadWord(packet, 0);
+      reportedBalance = payloadLong(packet, 2);
+      if (reportedBalance != coins - spinCost * (long)spins + payouts) {
+        ledgerBroken = true;
+      }
+      break;
+  }
+  changed = true;
+}
+
+static void press(uint8_t pin) {
+  nativeSetInput(pin, LOW);
+  nativeSetInput(interruptPin, LOW);
+}
+
+static void release(uint8_t pin) {
+  nativeReleaseInput(interruptPin);
+  nativeReleaseInput(pin);
+}
+
+static void draw(bool clear) {
+  char status[96];
+  long cents;
+  bool shown = readBalance(balanceDisplay, cents);
+  snprintf(status, sizeof(status), "%9.3f s  %-14s  rounds %lu  balance %s%ld.%02ld",
+           nativeNow() / 1e6, state < 7 ? stateNames[state] : "?", rounds,
+           shown && cents < 0 ? "-" : "", shown ? labs(cents) / 100 : 0, shown ? labs(cents) % 100 : 0);
+  if (clear) {
+    fputs("\x1b[H\x1b[2J", stdout);
+  }
+  renderFrame(stdout, reels, balanceDisplay, status);
+  if (!clear) {
+    fputc('\n', stdout);
+  }
+  fflush(stdout);
+}
+
+static int summary(clock_t started, unsigned long targetRounds) {
+  long cents = 0;
+  bool shown = readBalance(balanceDisplay, cents);
+  long expected = coins - spinCost * (long)spins + payouts;
+  // an autoplay or queued round may have taken its stake since the last report
+  long reportedExpected = expected + (state >= 2 && state <= 5 ? spinCost : 0);
+  printf("rounds %lu in %.1f s virtual time (%.0f games per hour), %.2f s CPU\n", rounds,
+         nativeNow() / 1e6, rounds * 3600e6 / nativeNow(), (double)(clock() - started) / CLOCKS_PER_SEC);
+  printf("coins %ld.%02ld  stakes %ld.%02ld  payouts %ld.%02ld  return %.1f %%\n",
+         coins / 100, coins % 100, spinCost * (long)spins / 100, spinCost * (long)spins % 100,
+         payouts / 100, payouts % 100, spins > 0 ? 100.0 * payouts / (spinCost * spins) : 0.0);
+  for (uint8_t i = 0; i < outcomeCount; i++) {
+    printf("  %-4s %lu\n", outcomeNames[i], outcomes[i]);
+  }
+  printf("balance expected %ld, reported %ld, displayed %s%ld\n", expected, reportedBalance,
+         shown ? "" : "(unreadable) ", cents);
+  // the reels stop within quickStopTime, the loop and the serial line add a little
+  bool quickStopsInTime = quickStopWorst <= (config.quickStopTime + 20) * 1000ULL;
+  if (queueSpins) {
+    printf("queue: %lu presses, %lu rounds started on their own\n", queuePresses, queuedStarts);
+  }
+  if (quickStops) {
+    printf("quick stop: %lu presses, press to payout %.0f ms average, %.0f ms worst\n",
+           quickStopCount, quickStopCount > 0 ? quickStopTotal / 1e3 / quickStopCount : 0.0,
+           quickStopWorst / 1e3);
+  }
+  if (coinPulses) {
+    printf("validator: %ld.%02ld inserted\n", validator.inserted() / 100, validator.inserted() % 100);
+  }
+  printf("display: %lu transactions, %lu errors, %lu timing violations; damaged telemetry frames: %lu\n",
+         balanceDisplay.transactions(), balanceDisplay.errors(), balanceDisplay.violations(),
+         reader.damaged());
+  // the bus calibration probes faster than the chip allows on purpose, those bytes were dropped
+  balanceDisplay.report(stdout);
+  if (rounds < targetRounds) {
+    printf("only %lu of %lu rounds played\n", rounds, targetRounds);
+  }
+  bool ok = rounds >= targetRounds && !ledgerBroken && shown && cents == expected && reportedBalance == reportedExpected &&
+            balanceDisplay.errors() == 0 && reader.damaged() == 0 &&
+            (!coinPulses || validator.inserted() == coins) &&
+            (!quickStops || (quickStopCount > 0 && quickStopsInTime)) &&
+            (!queueSpins || (queuePresses > 0 && queuedStarts == queuePresses));
+  printf("%s\n", ok ? "OK" : "MISMATCH");
+  return ok ? 0 : 1;
+}
+
+static void turbo() {
+  config.set("frameTime", 10);
+  config.set("spinTime", 0);
+  config.set("waitBeforeIdle", 0);
+  config.set("blinkTime", 10);
+  // the landing steps slow down from startSpeed to minSpeed whatever the frameTime
+  config.set("startSpeed", 60);
+  config.set("minSpeed", 80);
+}
+
+int main(int argc, char **argv) {
+  static const struct option options[] = {
+    {"speed",       required_argument, NULL, 's'},
+    {"duration",    required_argument, NULL, 'd'},
+    {"loop-us",     required_argument, NULL, 'l'},
+    {"rounds",      required_argument, NULL, 'r'},
+    {"turbo",       no_argument,       NULL, 't'},
+    {"quiet",       no_argument,       NULL, 'q'},
+    {"coin-pulses", no_argument,       NULL, 'p'},
+    {"queue",       no_argument,       NULL, 'u'},
+    {"autoplay",    no_argument,       NULL, 'a'},
+    {"quick-stop",  no_argument,       NULL, 'k'},
+    {"idle",        required_argument, NULL, 'g'},
+    {"eeprom",      required_argument, NULL, 'e'},
+    {"boot",        required_argument, NULL, 'b'},
+    {"script",      required_argument, NULL, 'i'},
+    {"save-script", required_argument, NULL, 'o'},
+    {"record",      required_argument, NULL, 'w'},
+    {"compare",     required_argument, NULL, 'c'},
+    {NULL, 0, NULL, 0}
+  };
+  double speed = 1;
+  uint64_t duration = 0;
+  uint64_t loopTime = 0;
+  unsigned long targetRounds = 0;
+  uint64_t idleTime = 0;
+  bool fast = false;
+  bool quiet = false;
+  InputScript script;
+  bool scripted = false;
+  const char *savePath = NULL;
+  bool traced = true;
+  int opt;
+
+  while ((opt = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    switch (opt) {
+      case 's':
+        speed = atof(optarg);
+        break;
+      case 'd':
+        duration = strtoull(optarg, NULL, 10) * 1000;
+        break;
+      case 'l':
+        loopTime = strtoull(optarg, NULL, 10);
+        break;
+      case 'r':
+        targetRounds = strtoul(optarg, NULL, 10);
+        break;
+      case 't':
+        fast = true;
+        break;
+      case 'q':
+        quiet = true;
+        break;
+      case 'p':
+        coinPulses = true;
+        break;
+      case 'u':
+        queueSpins = true;
+        break;
+      case 'a':
+        autoplay = true;
+        break;
+      case 'k':
+        quickStops = true;
+        break;
+      case 'g':
+        idleTime = strtoull(optarg, NULL, 10) * 1000;
+        break;
+      case 'e':
+        EEPROM.attach(optarg);
+        break;
+      case 'b':
+        nativeSetBootTime(strtoull(optarg, NULL, 10));
+        break;
+      case 'i':
+        if (!script.load(optarg)) {
+          return 2;
+        }
+        scripted = true;
+        break;
+      case 'o':
+        savePath = optarg;
+        break;
+      case 'w':
+        traced = trace.record(optarg, registerCount);
+        break;
+      case 'c':
+        traced = trace.compare(optarg, registerCount);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [--speed x] [--duration ms] [--loop-us us] [--rounds n] "
+                        "[--turbo] [--quiet] [--coin-pulses] [--queue | --autoplay | --quick-stop] "
+                        "[--idle ms] [--eeprom file] [--boot us] [--script file] "
+                        "[--save-script file] [--record trace | --compare trace]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (!traced) {
+    return 2;
+  }
+  if (scripted) {
+    // the script decides everything that changes the frames
+    targetRounds = 0;
+    fast = script.turbo;
+    loopTime = script.loopTime != 0 ? script.loopTime : loopTime;
+    duration = script.end != 0 ? script.end : duration;
+  }
+  if (loopTime == 0) {
+    // a turbo round is short enough that 1 ms per loop still sees every frame
+    loopTime = fast ? 1000 : 100;
+  }
+  script.turbo = fast;
+  script.loopTime = loopTime;
+
+  nativeSetSpeed(speed);
+  nativeAddPinListener(onPin);
+  Serial.capture(onSerial);
+  bool clear = isatty(STDOUT_FILENO);
+  uint64_t start = nativeNow();
+  clock_t started = clock();
+
+  randomSeed(script.seed);
+  setup();
+  if (fast) {
+    turbo();
+  }
+  if (queueSpins) {
+    // every press during a round queues one, and a turbo round outlasts the 1 s the
+    // firmware ignores presses after the one that started it
+    config.set("quickStopTime", 0);
+    if (fast) {
+      config.set("spinTime", 1500);
+    }
+  }
+
+  uint64_t nextFrame = 0;
+  uint64_t nextPress = nativeNow();
+  uint64_t releaseAt = 0;
+  uint8_t pressed = 0;
+  size_t nextEvent = 0;
+  // round (counted in spins) the player pressed the trigger during
+  unsigned long pressedInRound = ~0UL;
+  uint64_t finishAt = 0;
+  uint64_t idleUntil = 0;
+  while ((duration == 0 || nativeNow() - start < duration) && !trace.diverged()) {
+    loop();
+    nativeAdvance(nativeNow() < idleUntil ? idleLoopTime : loopTime);
+    uint64_t now = nativeNow();
+
+    if (pressed != 0 && now >= releaseAt) {
+      release(pressed);
+      pressed = 0;
+    }
+    if (scripted) {
+      // coins go into the validator even while a button is held
+      while (nextEvent < script.events.size() && now >= script.events[nextEvent].at &&
+             (pressed == 0 || script.events[nextEvent].cents != 0)) {
+        const InputEvent &event = script.events[nextEvent++];
+        if (event.cents != 0) {
+          validator.insert(event.cents);
+        } else {
+          pressed = event.pin;
+          press(pressed);
+          releaseAt = now + (event.length != 0 ? event.length : pressLength);
+        }
+      }
+      if (duration == 0 && nextEvent == script.events.size() && pressed == 0 && !validator.isBusy()) {
+        break;
+      }
+    } else if (idleTime != 0 && idleUntil == 0 && state == 1 && pressed == 0 && rounds >= targetRounds / 2) {
+      // walks away from the idle machine, the next press comes after the gap
+      idleUntil = now + idleTime;
+      nextPress = idleUntil;
+    } else if (targetRounds > 0 && pressed == 0 && now >= nextPress && rounds < targetRounds) {
+      long balance = coins - spinCost * (long)spins + payouts;
+      uint16_t coin = 0;
+      uint64_t length = 0;
+      if (state == 0) {
+        pressed = triggerPin;
+      } else if (state == 1 || (state == 6 && !autoplay && !(queueSpins && pressedInRound == spins))) {
+        // in WAITING the queued round starts on its own
+        if (balance >= spinCost) {
+          pressed = triggerPin;
+          startPressed = true;
+          length = autoplay ? holdLength : 0;
+          // and one more coin while the reels spin, credited once the round is over;
+          // not too many, the display shows 99.99 at most
+          coin = coinPulses && balance < 10 * spinCost ? 50 : 0;
+        } else if (coinPulses) {
+          coin = 200;
+        } else {
+          pressed = twoEurosPin;
+        }
+      } else if (queueSpins && state >= 2 && state <= 5 && spins != pressedInRound && balance >= spinCost &&
+                 rounds + 1 < targetRounds) {
+        // pays for the next round while this one runs, unless this is the last one
+        pressed = triggerPin;
+        pressedInRound = spins;
+        queuePresses++;
+      } else if (quickStops && (state == 3 || state == 4) && spins != pressedInRound) {
+        pressed = triggerPin;
+        pressedInRound = spins;
+        quickStopAt = now;
+      }
+      if (pressed != 0) {
+        press(pressed);
+        script.add(now, pressed, 0, length);
+        releaseAt = now + (length != 0 ? length : pressLength);
+      }
+      if (coin != 0) {
+        validator.insert(coin);
+        script.add(now, coinPulsePin, coin);
+      }
+      if (pressed != 0 || coin != 0) {
+        nextPress = now + pressInterval;
+      }
+    }
+    validator.update(now);
+    if (targetRounds > 0 && rounds >= targetRounds) {
+      if (finishAt == 0) {
+        // let the balance animation settle
+        finishAt = now + 2000000;
+      } else if (now >= finishAt) {
+        break;
+      }
+    }
+
+    if (!quiet && changed && now >= nextFrame) {
+      draw(clear);
+      changed = false;
+      nextFrame = now + frameInterval;
+    }
+  }
+  if (!quiet) {
+    draw(clear);
+  }
+
+  int result = 0;
+  if (savePath != NULL) {
+    script.end = nativeNow();
+    result |= script.save(savePath) ? 0 : 2;
+  }
+  if (!trace.complete()) {
+    result |= 1;
+  }
+  if (!trace.close()) {
+    result |= 2;
+  }
+  if (trace.frames() > 0 && !trace.diverged() && !quiet) {
+    fprintf(stderr, "%lu frames traced\n", trace.frames());
+  }
+  if (targetRounds > 0) {
+    result |= summary(started, targetRounds);
+  }
+  return result;
+}
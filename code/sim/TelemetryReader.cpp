@@ -0,0 +1,62 @@
+#include "TelemetryReader.h"
+#include "Crc16.h"
+
+TelemetryReader::TelemetryReader() : _size(0), _overflow(false), _damaged(0) {
+}
+
+bool TelemetryReader::feed(uint8_t value) {
+  if (value != 0) {
+    if (_size < sizeof(_frame)) {
+      _frame[_size++] = value;
+    } else {
+      _overflow = true;     // a console reply, most likely
+    }
+    return false;
+  }
+  bool valid = _size > 0 && !_overflow && decode();
+  _size = 0;
+  _overflow = false;
+  return valid;
+}
+
+bool TelemetryReader::decode() {
+  // COBS: every code byte tells where the next zero was
+  uint8_t packet[sizeof(_frame)];
+  uint8_t length = 0;
+  uint8_t i = 0;
+  while (i < _size) {
+    uint8_t code = _frame[i];
+    if (code == 0 || i + code > _size) {
+      return false;
+    }
+    for (uint8_t j = 1; j < code; j++) {
+      packet[length++] = _frame[i + j];
+    }
+    i += code;
+    if (code < 0xFF && i < _size) {
+      packet[length++] = 0;
+    }
+  }
+
+  if (length < 8 || length - 8 > TELEMETRY_MAX_PAYLOAD) {
+    return false;
+  }
+  uint16_t crc = crc16Init;
+  for (uint8_t j = 0; j < length - 2; j++) {
+    crc = crc16Update(crc, packet[j]);
+  }
+  if (crc != (packet[length - 2] | (packet[length - 1] << 8))) {
+    _damaged++;
+    return false;
+  }
+
+  _packet.type = packet[0];
+  _packet.sequence = packet[1];
+  _packet.millis = (uint32_t)packet[2] | ((uint32_t)packet[3] << 8) |
+                   ((uint32_t)packet[4] << 16) | ((uint32_t)packet[5] << 24);
+  _packet.length = length - 8;
+  for (uint8_t j = 0; j < _packet.length; j++) {
+    _packet.payload[j] = packet[6 + j];
+  }
+  return true;
+}
@@ -0,0 +1,41 @@
+#ifndef TELEMETRY_READER_H
+#define TELEMETRY_READER_H
+
+#include <stdint.h>
+#include "Telemetry.h"
+
+/*
+Decodes the serial output of the firmware back into telemetry packets (see
+include/Telemetry.h and tools/telemetry_decode.py). Console replies and damaged
+frames are skipped.
+*/
+
+struct TelemetryPacket {
+  uint8_t  type;
+  uint8_t  sequence;
+  uint32_t millis;
+  uint8_t  payload[TELEMETRY_MAX_PAYLOAD];
+  uint8_t  length;
+};
+
+class TelemetryReader {
+public:
+  TelemetryReader();
+
+  // Feeds one byte, returns true when it completed a valid packet
+  bool    feed(uint8_t value);
+  const TelemetryPacket &packet() const { return _packet; }
+
+  unsigned long damaged() const { return _damaged; }
+
+private:
+  bool    decode();
+
+  uint8_t _frame[2 * (8 + TELEMETRY_MAX_PAYLOAD)];
+  uint8_t _size;
+  bool    _overflow;
+  TelemetryPacket _packet;
+  unsigned long _damaged;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include <Arduino.h>
+#include "ArduinoNative.h"
+#include "Tm1637Model.h"
+
+static const char *const violationNames[TM1637_VIOLATION_KINDS] = {
+  "clock low", "clock high", "setup", "hold", "start hold", "stop setup"
+};
+
+Tm1637Model::Tm1637Model(uint8_t clockPin, uint8_t dataPin, const Tm1637Timing &timing) :
+  _clockPin(clockPin), _dataPin(dataPin), _timing(timing), _clockLevel(HIGH), _dataLevel(HIGH),
+  _active(false), _acknowledging(false), _reading(false), _readPending(false), _violated(false),
+  _bit(0), _value(0), _index(0), _writingData(false), _fixedAddress(false), _address(0),
+  _control(0), _keys(0xFF), _clockChanged(0), _dataChanged(0), _clockRose(0),
+  _transactions(0), _bytes(0), _errors(0) {
+  for (uint8_t i = 0; i < TM1637_MODEL_DIGITS; i++) {
+    _ram[i] = 0;
+  }
+  for (uint8_t i = 0; i < TM1637_VIOLATION_KINDS; i++) {
+    _violations[i] = 0;
+    _shortest[i] = UINT32_MAX;
+  }
+}
+
+void Tm1637Model::onPin(uint8_t pin, uint8_t level, uint64_t micros) {
+  uint64_t now = micros * 1000;
+  if (pin == _dataPin) {
+    if (_clockLevel && _dataLevel && !level) {
+      // DIO falls while CLK is high: start
+      _active = true;
+      _reading = false;
+      _readPending = false;
+      _violated = false;
+      _bit = 0;
+      _value = 0;
+      _index = 0;
+      _transactions++;
+    } else if (_clockLevel && !_dataLevel && level && _active) {
+      // DIO rises while CLK is high: stop. Its rising clock edge sampled one bit already
+      check(TM1637_STOP_SETUP, _clockChanged, now, _timing.stopSetup);
+      if (_bit > 1) {
+        _errors++;
+      }
+      _active = false;
+      _acknowledging = false;
+      _reading = false;
+      nativeReleaseInput(_dataPin);
+    } else if (_active && !_reading) {
+      check(TM1637_HOLD, _clockRose, now, _timing.hold);
+    }
+    _dataLevel = level;
+    _dataChanged = now;
+  } else if (pin == _clockPin) {
+    if (_active && level && !_clockLevel) {
+      check(TM1637_CLOCK_LOW, _clockChanged, now, _timing.clockLow);
+      if (_bit < 8) {
+        if (!_reading) {
+          check(TM1637_SETUP, _dataChanged, now, _timing.setup);
+          _value |= (digitalRead(_dataPin) ? 1 : 0) << _bit;
+        }
+        _bit++;
+      } else if (_bit == 8) {
+        if (!_reading && (!_violated || !_timing.strict)) {
+          received(_value);
+        }
+        _bit = 9;
+      }
+      _clockRose = now;
+    } else if (_active && !level && _clockLevel) {
+      bool first = _index == 0 && _bit == 0;
+      if (first) {
+        check(TM1637_START_HOLD, _dataChanged, now, _timing.startHold);
+      } else {
+        check(TM1637_CLOCK_HIGH, _clockChanged, now, _timing.clockHigh);
+      }
+      if (_bit == 8 && !_acknowledging) {
+        // the acknowledge only says that nine clocks came, whatever their timing
+        drive(LOW);
+        _acknowledging = true;
+      } else if (_bit == 9) {
+        _acknowledging = false;
+        _bit = 0;
+        _value = 0;
+        _violated = false;
+        _index++;
+        // after a read command the key code follows, its bit 0 goes out right away
+        _reading = _readPending;
+        _readPending = false;
+        drive(_reading ? _keys & 0x01 : HIGH);
+      } else if (_reading && _bit < 8) {
+        drive((_keys >> _bit) & 0x01);
+      }
+    }
+    _clockLevel = level;
+    _clockChanged = now;
+  }
+}
+
+void Tm1637Model::drive(uint8_t level) {
+  if (level) {
+    nativeReleaseInput(_dataPin);
+  } else {
+    nativeSetInput(_dataPin, LOW);
+  }
+  // the listeners only see changes of the combined level, follow what this one did
+  _dataLevel = digitalRead(_dataPin);
+}
+
+void Tm1637Model::check(Tm1637Violation kind, uint64_t since, uint64_t now, uint16_t minimum) {
+  uint64_t interval = now - since + _timing.writeTime;
+  if (interval >= minimum) {
+    return;
+  }
+  _violations[kind]++;
+  if (interval < _shortest[kind]) {
+    _shortest[kind] = interval;
+  }
+  _violated = true;
+}
+
+unsigned long Tm1637Model::violations() const {
+  unsigned long total = 0;
+  for (uint8_t i = 0; i < TM1637_VIOLATION_KINDS; i++) {
+    total += _violations[i];
+  }
+  return total;
+}
+
+void Tm1637Model::report(FILE *out) const {
+  for (uint8_t i = 0; i < TM1637_VIOLATION_KINDS; i++) {
+    if (_violations[i] > 0) {
+      fprintf(out, "  %-10s %lu violations, shortest %lu ns\n", violationNames[i],
+              _violations[i], (unsigned long)_shortest[i]);
+    }
+  }
+}
+
+void Tm1637Model::received(uint8_t value) {
+  _bytes++;
+  if (_index == 0) {
+    switch (value & 0xC0) {
+      case 0x40:    // data set, 0x04 fixed address, 0x02 read keys
+        _fixedAddress = value & 0x04;
+        _readPending = value & 0x02;
+        _writingData = false;
+        break;
+      case 0xC0:    // address set, data follows
+        _address = value & 0x07;
+        _writingData = true;
+        break;
+      case 0x80:    // display control
+        _control = value & 0x0F;
+        _writingData = false;
+        break;
+      default:
+        _writingData = false;
+        break;
+    }
+    return;
+  }
+  if (_writingData) {
+    if (_address < TM1637_MODEL_DIGITS) {
+      _ram[_address] = value;
+    }
+    if (!_fixedAddress) {
+      _address++;
+    }
+  }
+}
@@ -0,0 +1,103 @@
+#ifndef TM1637_MODEL_H
+#define TM1637_MODEL_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+A TM1637 rebuilt from the timestamped level changes of its CLK and DIO pins (feed
+every change to onPin()). It acknowledges every byte by pulling DIO low from the
+falling clock edge after the eighth bit to the falling edge after the ninth, like
+the chip, so the drivers see a connected display.
+
+Understands the write commands: data set (auto increment or fixed address), address
+set followed by data bytes, and display control (on/off and pulse width). After a
+data set command for reading it shifts the key code (setKeys()) out on DIO, bit 0
+first, changing DIO on the falling clock edges.
+
+Every interval the bus timing depends on is checked against minimum times
+(Tm1637Timing). Virtual time only moves in delays, so back to back pin writes would
+take no time at all; writeTime is added to every interval for the time one write
+takes on the board. With strict on a byte with a violation is dropped, as if the
+chip had latched garbage. It is acknowledged all the same: the acknowledge only
+depends on the clock count, so a calibration that goes by acknowledges (see
+TM1637Calibration.h) is checked against the timing and not against its own criterion.
+*/
+
+#define TM1637_MODEL_DIGITS 6
+
+// Minimum times in ns
+struct Tm1637Timing {
+  uint16_t clockLow;      // CLK pulse widths
+  uint16_t clockHigh;
+  uint16_t setup;         // DIO stable before the rising CLK edge
+  uint16_t hold;          // and after it
+  uint16_t startHold;     // DIO low (start) to CLK low
+  uint16_t stopSetup;     // CLK high to DIO high (stop)
+  uint16_t writeTime;     // one pin write on the board (FastGPIO: 2 cycles at 16 MHz)
+  bool     strict;        // drop bytes with violations
+};
+
+// Datasheet pulse width, setup and hold; start and stop as for I2C
+const Tm1637Timing tm1637DatasheetTiming = {400, 400, 100, 100, 100, 100, 125, true};
+
+enum Tm1637Violation {
+  TM1637_CLOCK_LOW, TM1637_CLOCK_HIGH, TM1637_SETUP, TM1637_HOLD,
+  TM1637_START_HOLD, TM1637_STOP_SETUP, TM1637_VIOLATION_KINDS
+};
+
+class Tm1637Model {
+public:
+  Tm1637Model(uint8_t clockPin, uint8_t dataPin, const Tm1637Timing &timing = tm1637DatasheetTiming);
+
+  void    onPin(uint8_t pin, uint8_t level, uint64_t micros);
+  void    setTiming(const Tm1637Timing &timing) { _timing = timing; }
+  // Key code the next read command returns, 0xFF is no key
+  void    setKeys(uint8_t code) { _keys = code; }
+
+  // Display RAM, digit 0 is the leftmost
+  uint8_t digit(uint8_t i) const { return i < TM1637_MODEL_DIGITS ? _ram[i] : 0; }
+  bool    isOn() const { return _control & 0x08; }
+  // Pulse width 1..8 (of 16), as set by the display control command
+  uint8_t brightness() const { return (_control & 0x07) + 1; }
+  // Last display control command, 0x08 on/off and the pulse width
+  uint8_t control() const { return _control; }
+
+  unsigned long transactions() const { return _transactions; }
+  unsigned long bytes() const { return _bytes; }
+  // Transactions that stopped in the middle of a byte
+  unsigned long errors() const { return _errors; }
+  unsigned long violations(Tm1637Violation kind) const { return _violations[kind]; }
+  unsigned long violations() const;
+  // Counts per kind and the shortest interval seen for each, nothing if there were none
+  void    report(FILE *out) const;
+
+private:
+  void    received(uint8_t value);
+  void    check(Tm1637Violation kind, uint64_t since, uint64_t now, uint16_t minimum);
+  void    drive(uint8_t level);
+
+  uint8_t _clockPin, _dataPin;
+  Tm1637Timing _timing;
+  uint8_t _clockLevel, _dataLevel;
+  bool    _active;          // between start and stop condition
+  bool    _acknowledging;   // DIO pulled low for the acknowledge
+  bool    _reading;         // the next bytes go out to the master
+  bool    _readPending;     // a read command was acknowledged, key code follows
+  bool    _violated;        // in the current byte
+  uint8_t _bit;             // bits of the current byte, 8 while acknowledging
+  uint8_t _value;
+  uint8_t _index;           // bytes in this transaction
+  bool    _writingData;     // first byte was an address command
+  bool    _fixedAddress;
+  uint8_t _address;
+  uint8_t _control;
+  uint8_t _keys;
+  uint8_t _ram[TM1637_MODEL_DIGITS];
+  uint64_t _clockChanged, _dataChanged, _clockRose;   // ns
+  unsigned long _transactions, _bytes, _errors;
+  unsigned long _violations[TM1637_VIOLATION_KINDS];
+  uint32_t _shortest[TM1637_VIOLATION_KINDS];
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include "AnimationVM.h"
+
+// Outer segments in clockwise order: top, upper right, lower right, bottom, lower left, upper left
+const uint8_t ringSegments[6] = {0x80, 0x20, 0x08, 0x02, 0x04, 0x40};
+const uint8_t ringMask = 0x80 | 0x20 | 0x08 | 0x02 | 0x04 | 0x40;
+
+// Segment pairs that swap places when a digit is mirrored
+const uint8_t mirroredReels[2][2] = {{0x40, 0x20}, {0x04, 0x08}};
+const uint8_t mirroredRows[3][2] = {{0x80, 0x02}, {0x40, 0x04}, {0x20, 0x08}};
+
+static byte swapSegments(byte value, const uint8_t pairs[][2], uint8_t count) {
+  byte result = value;
+  for (uint8_t i = 0; i < count; i++) {
+    result &= ~(pairs[i][0] | pairs[i][1]);
+    if (value & pairs[i][0]) {
+      result |= pairs[i][1];
+    }
+    if (value & pairs[i][1]) {
+      result |= pairs[i][0];
+    }
+  }
+  return result;
+}
+
+static byte rotateSegments(byte value, uint8_t steps) {
+  byte result = value & ~ringMask;
+  for (uint8_t i = 0; i < 6; i++) {
+    if (value & ringSegments[i]) {
+      result |= ringSegments[(i + steps) % 6];
+    }
+  }
+  return result;
+}
+
+// Whether index is selected by one nibble of a cell
+static bool selects(uint8_t nibble, uint8_t index) {
+  return nibble == ANIM_ALL || nibble == index;
+}
+
+void AnimationVM::start(const uint8_t *program) {
+  _program = program;
+  _pc = 0;
+  _loops = 0;
+  for (uint8_t i = 0; i < ANIMATION_REGISTERS; i++) {
+    _registers[i] = 0;
+  }
+  memset(frame, 0, sizeof(frame));
+}
+
+uint16_t AnimationVM::step() {
+  for (uint8_t ops = 0; ops < ANIMATION_MAX_OPS && _program != NULL; ops++) {
+    uint8_t op = fetch();
+    switch (op) {
+      case ANIM_SET: {
+        uint8_t cell = fetch();
+        set(cell, fetch());
+        break;
+      }
+      case ANIM_SETR: {
+        uint8_t cell = fetch();
+        set(cell, _registers[fetch() % ANIMATION_REGISTERS]);
+        break;
+      }
+      case ANIM_LD: {
+        uint8_t reg = fetch() % ANIMATION_REGISTERS;
+        _registers[reg] = fetch();
+        break;
+      }
+      case ANIM_ADD: {
+        uint8_t reg = fetch() % ANIMATION_REGISTERS;
+        _registers[reg] += fetch();
+        break;
+      }
+      case ANIM_XOR: {
+        uint8_t reg = fetch() % ANIMATION_REGISTERS;
+        _registers[reg] ^= fetch();
+        break;
+      }
+      case ANIM_ROT: {
+        uint8_t cell = fetch();
+        rotate(cell, fetch());
+        break;
+      }
+      case ANIM_SHIFTR:
+        shiftRows(fetch());
+        break;
+      case ANIM_SHIFTC:
+        shiftReels(fetch());
+        break;
+      case ANIM_MIRROR:
+        mirror(fetch());
+        break;
+      case ANIM_LOOP: {
+        uint8_t count = fetch();
+        if (_loops == ANIMATION_LOOP_DEPTH) {
+          // its NEXT would repeat the enclosing loop, end it like an unknown opcode
+          _program = NULL;
+          break;
+        }
+        _loopStart[_loops] = _pc;
+        _loopCount[_loops] = count;
+        _loops++;
+        break;
+      }
+      case ANIM_NEXT:
+        if (_loops > 0) {
+          uint8_t &count = _loopCount[_loops - 1];
+          if (count == 0 || --count > 0) {
+            _pc = _loopStart[_loops - 1];
+          } else {
+            _loops--;
+          }
+        }
+        break;
+      case ANIM_WAIT: {
+        uint16_t time = fetch() * 10;
+        return time > 0 ? time : 1;
+      }
+      case ANIM_END:
+      default:
+        _program = NULL;
+        break;
+    }
+  }
+  // ran out of instructions without a WAIT
+  return _program != NULL ? 10 : 0;
+}
+
+void AnimationVM::set(uint8_t cell, byte value) {
+  for (uint8_t row = 0; row < Geometry::rows; row++) {
+    for (uint8_t reel = 0; reel < Geometry::reels; reel++) {
+      if (selects(cell >> 4, row) && selects(cell & 0x0F, reel)) {
+        frame[row][reel] = value;
+      }
+    }
+  }
+}
+
+void AnimationVM::rotate(uint8_t cell, uint8_t steps) {
+  for (uint8_t row = 0; row < Geometry::rows; row++) {
+    for (uint8_t reel = 0; reel < Geometry::reels; reel++) {
+      if (selects(cell >> 4, row) && selects(cell & 0x0F, reel)) {
+        frame[row][reel] = rotateSegments(frame[row][reel], steps);
+      }
+    }
+  }
+}
+
+void AnimationVM::shiftRows(uint8_t steps) {
+  byte previous[Geometry::rows][Geometry::reels];
+  memcpy(previous, frame, sizeof(frame));
+  for (uint8_t row = 0; row < Geometry::rows; row++) {
+    memcpy(frame[(row + steps) % Geometry::rows], previous[row], Geometry::reels);
+  }
+}
+
+void AnimationVM::shiftReels(uint8_t steps) {
+  for (uint8_t row = 0; row < Geometry::rows; row++) {
+    byte previous[Geometry::reels];
+    memcpy(previous, frame[row], Geometry::reels);
+    for (uint8_t reel = 0; reel < Geometry::reels; reel++) {
+      frame[row][(reel + steps) % Geometry::reels] = previous[reel];
+    }
+  }
+}
+
+void AnimationVM::mirror(uint8_t axis) {
+  byte previous[Geometry::rows][Geometry::reels];
+  memcpy(previous, frame, sizeof(frame));
+  for (uint8_t row = 0; row < Geometry::rows; row++) {
+    for (uint8_t reel = 0; reel < Geometry::reels; reel++) {
+      if (axis == ANIM_MIRROR_REELS) {
+        frame[row][reel] = swapSegments(previous[row][Geometry::reels - 1 - reel], mirroredReels, 2);
+      } else if (axis == ANIM_MIRROR_ROWS) {
+        frame[row][reel] = swapSegments(previous[Geometry::rows - 1 - row][reel], mirroredRows, 3);
+      }
+    }
+  }
+}
@@ -0,0 +1,142 @@
+#include "CoinAcceptor.h"
+#include "Config.h"
+#include "CycleClock.h"
+#include "Wiring.h"
+
+CoinAcceptor coinAcceptor;
+
+const uint16_t coinValues[COIN_VALUE_COUNT] = {50, 100, 200};
+
+static const uint32_t cyclesPerMillisecond = CYCLES_PER_MICROSECOND * 1000UL;
+
+#ifdef __AVR__
+
+ISR(TIMER1_CAPT_vect) {
+  uint16_t count = ICR1;
+  uint8_t level = (TCCR1B & _BV(ICES1)) ? HIGH : LOW;
+  // catch the opposite edge next, switching the edge may flag a capture
+  TCCR1B ^= _BV(ICES1);
+  TIFR1 = _BV(ICF1);
+  coinAcceptor.capture(CycleClock::fromCapture(count), level);
+}
+
+#endif
+
+void CoinAcceptor::begin() {
+  pinMode(coinPulsePin, INPUT_PULLUP);
+  _head = 0;
+  _tail = 0;
+  _dropped = 0;
+  _level = digitalRead(coinPulsePin);
+  _train = false;
+  _invalid = false;
+  _pulses = 0;
+  _rejected = 0;
+  for (uint8_t i = 0; i < COIN_VALUE_COUNT; i++) {
+    _counted[i] = 0;
+  }
+#ifdef __AVR__
+  noInterrupts();
+  // noise canceler (4 equal samples), the next edge away from the current level
+  TCCR1B = (TCCR1B & ~_BV(ICES1)) | _BV(ICNC1) | (_level ? 0 : _BV(ICES1));
+  TIFR1 = _BV(ICF1);
+  TIMSK1 |= _BV(ICIE1);
+  interrupts();
+#endif
+}
+
+uint16_t CoinAcceptor::dropped() const {
+#ifdef __AVR__
+  // capture() counts on in the middle of reading both bytes otherwise
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t count = _dropped;
+  SREG = sreg;
+  return count;
+#else
+  return _dropped;
+#endif
+}
+
+void CoinAcceptor::capture(uint32_t time, uint8_t level) {
+  uint8_t next = (_head + 1) & (COIN_EDGE_BUFFER - 1);
+  if (next == _tail) {
+    _dropped++;
+    return;
+  }
+  _edges[_head] = (time & ~1UL) | (level ? 1 : 0);
+  _head = next;
+}
+
+void CoinAcceptor::poll() {
+#ifndef __AVR__
+  uint8_t level = digitalRead(coinPulsePin);
+  if (level != _level) {
+    capture(CycleClock::now(), level);
+  }
+#endif
+  // edges captured while decoding are newer than now, the gap below only looks back
+  uint32_t now = CycleClock::now();
+  while (_tail != _head) {
+    uint32_t entry = _edges[_tail];
+    _tail = (_tail + 1) & (COIN_EDGE_BUFFER - 1);
+    edge(entry & ~1UL, entry & 1);
+  }
+  if (_train && _level == HIGH &&
+      (int32_t)(now - _pulseEnd) > (int32_t)(config.coinTrainGap * cyclesPerMillisecond)) {
+    endTrain();
+  }
+}
+
+void CoinAcceptor::edge(uint32_t time, uint8_t level) {
+  if (level == _level && _train) {
+    // the edge in between got lost, so did a pulse or the end of one
+    _invalid = true;
+  }
+  _level = level;
+  if (level == LOW) {
+    if (_train && time - _pulseEnd > config.coinTrainGap * cyclesPerMillisecond) {
+      endTrain();
+    }
+    _pulseStart = time;
+    return;
+  }
+  uint32_t width = (time - _pulseStart) / cyclesPerMillisecond;
+  if (width < config.coinPulseMin) {
+    return;
+  }
+  if (width > config.coinPulseMax) {
+    _invalid = true;
+  } else if (_pulses < 255) {
+    _pulses++;
+  }
+  _train = true;
+  _pulseEnd = time;
+}
+
+void CoinAcceptor::endTrain() {
+  uint32_t cents = (uint32_t)_pulses * config.coinPulseValue;
+  uint8_t i = 0;
+  while (i < COIN_VALUE_COUNT && coinValues[i] != cents) {
+    i++;
+  }
+  if (_invalid || i == COIN_VALUE_COUNT) {
+    _rejected++;
+  } else if (_counted[i] < 255) {
+    _counted[i]++;
+  }
+  _train = false;
+  _invalid = false;
+  _pulses = 0;
+}
+
+bool CoinAcceptor::take(uint16_t &cents) {
+  for (uint8_t i = 0; i < COIN_VALUE_COUNT; i++) {
+    if (_counted[i] > 0) {
+      _counted[i]--;
+      cents = coinValues[i];
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,182 @@
+#include <EEPROM.h>
+#include <stddef.h>
+#include "Config.h"
+#include "Crc16.h"
+
+Config config;
+
+struct ConfigParameter {
+  const char *name;
+  uint8_t     offset;
+  uint16_t    min;
+  uint16_t    max;
+};
+
+const char frameTimeName[] PROGMEM = "frameTime";
+const char waitBeforeIdleName[] PROGMEM = "waitBeforeIdle";
+const char spinTimeName[] PROGMEM = "spinTime";
+const char topSpeedName[] PROGMEM = "topSpeed";
+const char minSpeedName[] PROGMEM = "minSpeed";
+const char startSpeedName[] PROGMEM = "startSpeed";
+const char minRandomAccellName[] PROGMEM = "minRandomAccell";
+const char maxRandomAccellName[] PROGMEM = "maxRandomAccell";
+const char blinkTimeName[] PROGMEM = "blinkTime";
+const char busDelayName[] PROGMEM = "busDelay";
+const char reelBrightnessName[] PROGMEM = "reelBrightness";
+const char idleBrightnessName[] PROGMEM = "idleBrightness";
+const char coinPulseMinName[] PROGMEM = "coinPulseMin";
+const char coinPulseMaxName[] PROGMEM = "coinPulseMax";
+const char coinTrainGapName[] PROGMEM = "coinTrainGap";
+const char coinPulseValueName[] PROGMEM = "coinPulseValue";
+const char spinQueueName[] PROGMEM = "spinQueue";
+const char roundPauseName[] PROGMEM = "roundPause";
+const char autoplayRoundsName[] PROGMEM = "autoplayRounds";
+const char autoplaySpinTimeName[] PROGMEM = "autoplaySpinTime";
+const char quickStopTimeName[] PROGMEM = "quickStopTime";
+const char soundName[] PROGMEM = "sound";
+
+const ConfigParameter parameters[] PROGMEM = {
+  {frameTimeName,       offsetof(Config, frameTime),       10, 5000},
+  {waitBeforeIdleName,  offsetof(Config, waitBeforeIdle),  0,  60000},
+  {spinTimeName,        offsetof(Config, spinTime),        0,  30000},
+  {topSpeedName,        offsetof(Config, topSpeed),        10, 2000},
+  {minSpeedName,        offsetof(Config, minSpeed),        10, 2000},
+  {startSpeedName,      offsetof(Config, startSpeed),      10, 2000},
+  {minRandomAccellName, offsetof(Config, minRandomAccell), 1,  500},
+  {maxRandomAccellName, offsetof(Config, maxRandomAccell), 1,  500},
+  {blinkTimeName,       offsetof(Config, blinkTime),       10, 5000},
+  {busDelayName,        offsetof(Config, busDelay),        0,  50},
+  {reelBrightnessName,  offsetof(Config, reelBrightness),  1,  15},
+  {idleBrightnessName,  offsetof(Config, idleBrightness),  0,  15},
+  {coinPulseMinName,    offsetof(Config, coinPulseMin),    1,  1000},
+  {coinPulseMaxName,    offsetof(Config, coinPulseMax),    1,  1000},
+  {coinTrainGapName,    offsetof(Config, coinTrainGap),    10, 2000},
+  {coinPulseValueName,  offsetof(Config, coinPulseValue),  1,  200},
+  {spinQueueName,       offsetof(Config, spinQueue),       0,  5},
+  {roundPauseName,      offsetof(Config, roundPause),      0,  60000},
+  {autoplayRoundsName,  offsetof(Config, autoplayRounds),  0,  100},
+  {autoplaySpinTimeName, offsetof(Config, autoplaySpinTime), 0, 30000},
+  {quickStopTimeName,   offsetof(Config, quickStopTime),   0,  1000},
+  {soundName,           offsetof(Config, sound),           0,  1},
+};
+
+const uint8_t parameterCount = sizeof(parameters) / sizeof(parameters[0]);
+const uint8_t configMagic = 'C';
+
+void Config::reset() {
+  frameTime = 500;
+  waitBeforeIdle = 10000;
+  spinTime = 5000;
+  topSpeed = 50;
+  minSpeed = 450;
+  startSpeed = 390;
+  minRandomAccell = 30;
+  maxRandomAccell = 40;
+  blinkTime = 250;
+  busDelay = 0;
+  reelBrightness = 15;
+  idleBrightness = 6;
+  coinPulseMin = 20;
+  coinPulseMax = 120;
+  coinTrainGap = 150;
+  coinPulseValue = 50;
+  spinQueue = 3;
+  roundPause = 1000;
+  autoplayRounds = 10;
+  autoplaySpinTime = 1000;
+  quickStopTime = 600;
+  sound = 1;
+}
+
+bool Config::load() {
+  if (EEPROM.read(EEPROM_CONFIG_START) != configMagic ||
+      EEPROM.read(EEPROM_CONFIG_START + 1) != CONFIG_VERSION ||
+      EEPROM.read(EEPROM_CONFIG_START + 2) != sizeof(Config)) {
+    return false;
+  }
+  Config stored;
+  EEPROM.get(EEPROM_CONFIG_START + 3, stored);
+  uint16_t storedCrc;
+  EEPROM.get(EEPROM_CONFIG_START + 3 + sizeof(Config), storedCrc);
+  if (storedCrc != stored.crc() || !stored.isConsistent()) {
+    return false;
+  }
+  *this = stored;
+  return true;
+}
+
+void Config::save() const {
+  EEPROM.update(EEPROM_CONFIG_START, configMagic);
+  EEPROM.update(EEPROM_CONFIG_START + 1, CONFIG_VERSION);
+  EEPROM.update(EEPROM_CONFIG_START + 2, sizeof(Config));
+  EEPROM.put(EEPROM_CONFIG_START + 3, *this);
+  EEPROM.put(EEPROM_CONFIG_START + 3 + sizeof(Config), crc());
+}
+
+bool Config::get(const char *name, uint16_t &value) const {
+  int index = find(name);
+  if (index < 0) {
+    return false;
+  }
+  value = *const_cast<Config *>(this)->field(index);
+  return true;
+}
+
+bool Config::set(const char *name, uint16_t value) {
+  int index = find(name);
+  if (index < 0 ||
+      value < pgm_read_word(&parameters[index].min) ||
+      value > pgm_read_word(&parameters[index].max)) {
+    return false;
+  }
+  uint16_t *target = field(index);
+  uint16_t previous = *target;
+  *target = value;
+  if (!isConsistent()) {
+    *target = previous;
+    return false;
+  }
+  return true;
+}
+
+uint8_t Config::count() const {
+  return parameterCount;
+}
+
+void Config::name(uint8_t index, char *buffer, uint8_t size) const {
+  const char *name = (const char *)pgm_read_ptr(&parameters[index].name);
+  strncpy_P(buffer, name, size - 1);
+  buffer[size - 1] = '\0';
+}
+
+int Config::find(const char *name) const {
+  for (uint8_t i = 0; i < parameterCount; i++) {
+    if (strcmp_P(name, (const char *)pgm_read_ptr(&parameters[i].name)) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool Config::isConsistent() const {
+  // speeds are ms per step: the reels must never step below zero or past rest
+  return topSpeed < startSpeed && startSpeed < minSpeed &&
+         minRandomAccell <= maxRandomAccell && maxRandomAccell <= topSpeed &&
+         coinPulseMin <= coinPulseMax;
+}
+
+uint16_t *Config::field(uint8_t index) {
+  return (uint16_t *)((uint8_t *)this + pgm_read_byte(&parameters[index].offset));
+}
+
+uint16_t Config::crc() const {
+  uint16_t crc = crc16Init;
+  crc = crc16Update(crc, configMagic);
+  crc = crc16Update(crc, CONFIG_VERSION);
+  crc = crc16Update(crc, sizeof(Config));
+  const uint8_t *bytes = (const uint8_t *)this;
+  for (uint8_t i = 0; i < sizeof(Config); i++) {
+    crc = crc16Update(crc, bytes[i]);
+  }
+  return crc;
+}
@@ -0,0 +1,68 @@
+#include "Console.h"
+
+void Console::begin(Stream &port) {
+  _port = &port;
+  _length = 0;
+  _overflow = false;
+  _discarding = false;
+  _argc = 0;
+}
+
+bool Console::poll() {
+  while (_port->available()) {
+    char c = _port->read();
+    if (c == '\r' || c == '\n') {
+      if (_discarding) {
+        // report the dropped line once, as an empty command
+        _discarding = false;
+        _overflow = true;
+        _length = 0;
+        _argc = 0;
+        return true;
+      }
+      if (_length == 0) {
+        continue;
+      }
+      _line[_length] = '\0';
+      _length = 0;
+      _overflow = false;
+      split();
+      return true;
+    }
+    if (_discarding) {
+      continue;
+    }
+    if (_length == CONSOLE_LINE_LENGTH) {
+      _discarding = true;
+      continue;
+    }
+    _line[_length++] = c;
+  }
+  return false;
+}
+
+bool Console::number(uint8_t index, long &value) const {
+  if (index >= _argc) {
+    return false;
+  }
+  char *end;
+  value = strtol(_argv[index], &end, 10);
+  return end != _argv[index] && *end == '\0';
+}
+
+void Console::split() {
+  _argc = 0;
+  char *c = _line;
+  while (*c != '\0' && _argc < CONSOLE_MAX_ARGS) {
+    while (*c == ' ' || *c == '\t') {
+      *c++ = '\0';
+    }
+    if (*c == '\0') {
+      break;
+    }
+    _argv[_argc++] = c;
+    while (*c != '\0' && *c != ' ' && *c != '\t') {
+      c++;
+    }
+  }
+}
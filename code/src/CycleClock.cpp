@@ -0,0 +1,53 @@
+#include "CycleClock.h"
+
+volatile uint16_t CycleClock::_overflows = 0;
+
+#ifdef __AVR__
+
+ISR(TIMER1_OVF_vect) {
+  CycleClock::overflow();
+}
+
+void CycleClock::begin() {
+  noInterrupts();
+  TCCR1A = 0;                 // normal mode, OC1A/OC1B disconnected
+  TCCR1B = _BV(CS10);         // clk / 1
+  TCNT1 = 0;
+  _overflows = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 |= _BV(TOIE1);
+  interrupts();
+}
+
+uint32_t CycleClock::now() {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t low = TCNT1;
+  uint16_t high = _overflows;
+  // an overflow that is still pending belongs to a low count read after it
+  if ((TIFR1 & _BV(TOV1)) && low < 0x8000) {
+    high++;
+  }
+  SREG = sreg;
+  return ((uint32_t)high << 16) | low;
+}
+
+uint32_t CycleClock::fromCapture(uint16_t count) {
+  uint16_t high = _overflows;
+  // same as in now(): the capture interrupt goes before a pending overflow
+  if ((TIFR1 & _BV(TOV1)) && count < 0x8000) {
+    high++;
+  }
+  return ((uint32_t)high << 16) | count;
+}
+
+#else
+
+void CycleClock::begin() {
+}
+
+uint32_t CycleClock::now() {
+  return micros() * CYCLES_PER_MICROSECOND;
+}
+
+#endif
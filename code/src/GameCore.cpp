@@ -0,0 +1,614 @@
+#include <string.h>
+#include "GameCore.h"
+#include "Config.h"
+#include "TM1637Font.h"
+
+/*
+Bit order from left to right
+
+   --0--
+  |     |
+  1     2
+  |     |
+   --3--
+  |     |
+  5     4
+  |     |
+   --6--   7
+
+*/
+
+// Attract animations played while idle, one after the other (see AnimationVM.h)
+const uint8_t sweepAnimation[] PROGMEM = {
+  ANIM_SET, ANIM_CELL(ANIM_ALL, 0), 0b01101100,   // both bars of the first reel
+  ANIM_LOOP, 2,
+    ANIM_LOOP, 3,
+      ANIM_WAIT, 25,
+      ANIM_SHIFTC, 1,
+    ANIM_NEXT,
+  ANIM_NEXT,
+  ANIM_END,
+};
+const uint8_t spinnerAnimation[] PROGMEM = {
+  ANIM_SET, ANIM_CELL(ANIM_ALL, ANIM_ALL), 0b10000000,
+  ANIM_ROT, ANIM_CELL(1, ANIM_ALL), 2,             // each row a third of a turn behind
+  ANIM_ROT, ANIM_CELL(2, ANIM_ALL), 4,
+  ANIM_LOOP, 24,
+    ANIM_WAIT, 10,
+    ANIM_ROT, ANIM_CELL(ANIM_ALL, ANIM_ALL), 1,
+  ANIM_NEXT,
+  ANIM_END,
+};
+const uint8_t rainAnimation[] PROGMEM = {
+  ANIM_SET, ANIM_CELL(0, ANIM_ALL), 0b10000000,
+  ANIM_SET, ANIM_CELL(1, 1), 0b00010000,
+  ANIM_LOOP, 9,
+    ANIM_WAIT, 15,
+    ANIM_SHIFTR, 1,
+    ANIM_SHIFTC, 1,
+  ANIM_NEXT,
+  ANIM_END,
+};
+const uint8_t mirrorAnimation[] PROGMEM = {
+  ANIM_SET, ANIM_CELL(ANIM_ALL, 0), 0b11000110,   // [ on the first reel
+  ANIM_LD, 0, 0b00010000,
+  ANIM_LOOP, 6,
+    ANIM_SETR, ANIM_CELL(1, 1), 0,
+    ANIM_WAIT, 30,
+    ANIM_MIRROR, ANIM_MIRROR_REELS,
+    ANIM_XOR, 0, 0b10000010,                     // centre toggles between - and three bars
+  ANIM_NEXT,
+  ANIM_END,
+};
+const uint8_t *const idleAnimations[] PROGMEM = {
+  sweepAnimation, spinnerAnimation, rainAnimation, mirrorAnimation,
+};
+const uint8_t idleAnimationAmount = sizeof(idleAnimations) / sizeof(idleAnimations[0]);
+
+// digits and texts for the balance display (TM1637 segment order)
+const uint8_t balanceDigits[10] PROGMEM = {
+  TM1637_CHAR_0, TM1637_CHAR_1, TM1637_CHAR_2, TM1637_CHAR_3, TM1637_CHAR_4,
+  TM1637_CHAR_5, TM1637_CHAR_6, TM1637_CHAR_7, TM1637_CHAR_8, TM1637_CHAR_9,
+};
+const uint8_t playText[4] = {TM1637_CHAR_P, TM1637_CHAR_L, TM1637_CHAR_A, TM1637_CHAR_Y};
+
+const uint8_t winSymbol = 0b10101000;
+const uint8_t loseSymbol = 0b00010000;
+
+// A spinning reel: a line runs down through every digit, one symbol step moves it to
+// the next segment, and in between both are lit (scrollSubsteps phases per step)
+const uint8_t scrollSubsteps = 2;
+const uint8_t scrollPhases[] PROGMEM = {
+  0b10000000, // top
+  0b11100000,
+  0b01100000, // upper sides
+  0b01110000,
+  0b00010000, // middle
+  0b00011100,
+  0b00001100, // lower sides
+  0b00001110,
+  0b00000010, // bottom
+  0b10000010,
+};
+const uint8_t scrollPhaseCount = sizeof(scrollPhases);
+static_assert(Geometry::rows / 2 * scrollSubsteps <= scrollPhaseCount, "rows above the middle would wrap twice");
+// A landing reel scrolls its result in one row per symbol step
+const uint16_t landingPhases = Geometry::rows * scrollSubsteps;
+// Longest speed ramp, planning a spin walks through every phase of its ramps
+const uint16_t maxRampPhases = 255;
+
+// Time the balance display stays on or off while it blinks
+const unsigned long balanceBlinkTime = 350;
+
+// Whether the digit in row of reel is part of the line of a winning outcome
+static bool isOnLine(WinType type, int row, int reel) {
+  switch (type) {
+    case HTOP:
+      return row == 0;
+    case HMID:
+      return row == Geometry::rows / 2;
+    case HBOT:
+      return row == Geometry::rows - 1;
+    case DTL:
+      return row == Geometry::diagonalRow(reel);
+    case DTR:
+      return row == Geometry::rows - 1 - Geometry::diagonalRow(reel);
+    case NONE:
+    default:
+      return false;
+  }
+}
+
+// Scroll phase of the digit in row at reel position, rows above the middle trail one step behind
+static uint8_t scrollPhase(uint8_t position, uint8_t row) {
+  return (position + scrollPhaseCount + (row - Geometry::rows / 2) * scrollSubsteps) % scrollPhaseCount;
+}
+
+// ms a phase of a ramp from one speed (ms per step) to the other over [start, end) takes
+static uint16_t rampDelay(uint16_t from, uint16_t to, uint16_t phase, uint16_t start, uint16_t end) {
+  long speed = from + ((long)to - from) * (phase - start + 1) / (end - start);
+  return speed / scrollSubsteps;
+}
+
+int GameCore::payoutFor(WinType type) {
+  switch (type) {
+    case HMID:
+      return 200;
+    case HTOP:
+    case HBOT:
+      return 100;
+    case DTL:
+    case DTR:
+      return 50;
+    case NONE:
+    default:
+      return 0;
+  }
+}
+
+GameCore::GameCore(const Config &config) :
+  _config(config), _reelsValid(false), _state(OFF), _currentIdleAnimation(0),
+  _blinkBalance(0), _queuedSpins(0), _autoplayRounds(0), _triggerHeld(false), _wintype(NONE),
+  _restSpeed(0), _fullSpeed(0), _landingSpeed(0), _spinStart(0), _spinDuration(0), _tickReel(0), _random(1) {
+  memset(&_out, 0, sizeof(_out));
+  _out.balanceOn = true;
+  memset(&_ledger, 0, sizeof(_ledger));
+  memset(_result, 0, sizeof(_result));
+  memset(_motion, 0, sizeof(_motion));
+  for (uint8_t i = 0; i < Geometry::reels; i++) {
+    _accel[i] = 0;
+  }
+  _attract.start((const uint8_t *)pgm_read_ptr(&idleAnimations[_currentIdleAnimation]));
+}
+
+const GameOutput &GameCore::step(unsigned long now, const GameInputs &inputs) {
+  _out.reelsChanged = false;
+  _out.balanceChanged = false;
+  _out.events = 0;
+  // a coin that came with a press still counts before the round starts
+  if (inputs.coin != 0) {
+    insert(inputs.coin);
+  }
+  if (inputs.trigger) {
+    press(now);
+  }
+  checkTriggerHold(now, inputs.triggerDown);
+  if (_ledger.displayLag != 0) {
+    _ledger.displayLag += _ledger.displayLag > 0 ? -5 : 5;
+    renderBalance();
+  }
+  if (_blinkBalance > 0) {
+    animateBalanceBlink(now);
+  }
+
+  bool past;
+  switch (_state) {
+  case OFF: {
+    uint8_t blank[Geometry::rows][Geometry::reels];
+    memset(blank, 0, sizeof(blank));
+    showReels(blank);
+    break;
+  }
+  case IDLE:
+    // the hold that turns autoplay on can outlast a short first round
+    if (takeQueuedRound()) {
+      _state = START_SPINNING;
+    } else if (_timers.expired(IDLE_FRAME_TIMER, now)) {
+      nextIdleAnimationFrame(now);
+    }
+    break;
+  case START_SPINNING:
+    if (_ledger.balance() >= spinCost) {
+      _ledger.bet += spinCost;
+      _ledger.displayLag -= spinCost;
+      startSpinning(now);
+    } else {
+      // out of credit, autoplay and queued rounds end here
+      _autoplayRounds = 0;
+      _queuedSpins = 0;
+      _blinkBalance = 6;
+      _state = _timers.expired(STAGE_TIMER, now) ? IDLE : WAITING;
+    }
+    break;
+  case SPINUP:
+    nextAnimationFrame(now);
+    past = true;
+    for (uint8_t i = 0; i < Geometry::reels; i++) {
+      past &= _motion[i].phase >= _motion[i].upEnd;
+    }
+    if (past) {
+      _state = SPINNING;
+    }
+    break;
+  case SPINNING:
+    nextAnimationFrame(now);
+    // SPINDOWN starts once the first reel slows down
+    for (uint8_t i = 0; i < Geometry::reels; i++) {
+      if (_motion[i].phase >= _motion[i].cruiseEnd) {
+        _state = SPINDOWN;
+      }
+    }
+    break;
+  case SPINDOWN:
+    nextAnimationFrame(now);
+    past = true;
+    for (uint8_t i = 0; i < Geometry::reels; i++) {
+      past &= _motion[i].phase >= _motion[i].stopPhase;
+    }
+    if (past) {
+      finishRound(now);
+    }
+    break;
+  case WAITING:
+    blinkWin(now);
+    if (_timers.expired(STAGE_TIMER, now)) {
+      _state = takeQueuedRound() ? START_SPINNING : IDLE;
+    }
+    break;
+  }
+  return _out;
+}
+
+void GameCore::payRecovered(uint16_t payout) {
+  _ledger.won += payout;
+  _ledger.displayLag += payout;
+}
+
+uint16_t GameCore::winCells() const {
+  uint16_t cells = 0;
+  for (uint8_t i = 0; i < Geometry::reels; i++) {
+    for (uint8_t j = 0; j < Geometry::rows; j++) {
+      if (_result[i][j] == winSymbol) {
+        cells |= 1 << Geometry::cellBit(j, i);
+      }
+    }
+  }
+  return cells;
+}
+
+// The first press of a round while the reels speed up or spin quick stops them (with
+// quickStopTime set); after that, and while they slow down, each press queues a round
+void GameCore::press(unsigned long now) {
+  if (_state == OFF) {
+    showBalance(playText);
+    _state = IDLE;
+  } else if (_autoplayRounds > 0) {
+    _autoplayRounds = 0;
+  } else if (_state == IDLE || _state == WAITING) {
+    _state = START_SPINNING;
+    _triggerHeld = true;
+  } else if (_config.quickStopTime > 0 && (_state == SPINUP || _state == SPINNING)) {
+    // goes on in SPINDOWN, so the next press queues
+    quickStop(now);
+  } else if (_queuedSpins < _config.spinQueue) {
+    _queuedSpins++;
+  }
+}
+
+void GameCore::insert(uint16_t coin) {
+  if (!acceptsCoins()) {
+    return;
+  }
+  _ledger.cashIn += coin;
+  _ledger.displayLag += coin;
+  _out.events |= GAME_COIN;
+  _out.coin = coin;
+}
+
+// Turns autoplay on once the press that started the round was held for autoplayHold
+void GameCore::checkTriggerHold(unsigned long now, bool down) {
+  if (!_triggerHeld) {
+    return;
+  }
+  if (!down) {
+    _triggerHeld = false;
+    _timers.stop(HOLD_TIMER);
+  } else if (!_timers.isRunning(HOLD_TIMER)) {
+    _timers.start(HOLD_TIMER, autoplayHold, now);
+  } else if (_timers.expired(HOLD_TIMER, now)) {
+    _triggerHeld = false;
+    if (_config.autoplayRounds > 0) {
+      // this round is the first one
+      _autoplayRounds = _config.autoplayRounds - 1;
+    }
+  }
+}
+
+// Whether another round follows without a press, takes it from autoplay or the queue
+bool GameCore::takeQueuedRound() {
+  if (_autoplayRounds > 0) {
+    _autoplayRounds--;
+  } else if (_queuedSpins > 0) {
+    _queuedSpins--;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void GameCore::startSpinning(unsigned long now) {
+  mix(now);
+  drawOutcome();
+  for (uint8_t i = 0; i < Geometry::reels; i++) {
+    _accel[i] = random(_config.minRandomAccell, _config.maxRandomAccell);
+  }
+  // the adapter puts the outcome on EEPROM before the first reel moves in the next step
+  _out.events |= GAME_ROUND_OPENED;
+  planSpin(_autoplayRounds > 0 ? _config.autoplaySpinTime : _config.spinTime, now);
+  _state = SPINUP;
+}
+
+void GameCore::drawOutcome() {
+  for (uint8_t i = 0; i < Geometry::reels; i++) {
+    for (uint8_t j = 0; j < Geometry::rows; j++) {
+      _result[i][j] = loseSymbol;
+    }
+  }
+  long randomOurcome = random(100);
+
+  if (randomOurcome < 25) { // (25%)
+    _wintype = NONE;
+    int emptyRow = random(Geometry::rows);
+    for (int j = 0; j < Geometry::rows; j++) {
+      for (int i = 0; i < Geometry::rows; i++) {
+        if (j == emptyRow) {
+          break;
+        }
+        _result[0][i] = random(2) ? winSymbol : loseSymbol;
+      }
+    }
+  } else if (randomOurcome < 50) { // (25%)
+    _wintype = random(2) ? DTL : DTR;
+  } else if (randomOurcome < 75) { // (25%)
+    _wintype = random(2) ? HTOP : HBOT;
+  } else {
+    _wintype = HMID; // (25%)
+  }
+  for (uint8_t i = 0; i < Geometry::reels; i++) {
+    for (uint8_t j = 0; j < Geometry::rows; j++) {
+      if (isOnLine(_wintype, j, i)) {
+        _result[i][j] = winSymbol;
+      }
+    }
+  }
+}
+
+// Phases a speed ramp of a reel takes: about as long as changing the speed by accel
+// every frameTime would, with the speed changing a little every phase instead
+uint16_t GameCore::rampPhases(uint16_t from, uint16_t to, unsigned long accel) const {
+  unsigned long time = (unsigned long)(from > to ? from - to : to - from) * _config.frameTime / accel;
+  unsigned long phases = time * 2 * scrollSubsteps / (from + to);
+  if (phases < 1) {
+    return 1;
+  }
+  return phases < maxRampPhases ? phases : maxRampPhases;
+}
+
+// ms from the current phase of a reel to its next
+uint16_t GameCore::phaseDelay(const ReelMotion &reel) const {
+  if (reel.phase < reel.upEnd) {
+    return rampDelay(_restSpeed, _fullSpeed, reel.phase, 0, reel.upEnd);
+  }
+  if (reel.phase < reel.cruiseEnd) {
+    return reel.cruiseDelay;
+  }
+  if (reel.phase < reel.downEnd) {
+    return rampDelay(_fullSpeed, _landingSpeed, reel.phase, reel.cruiseEnd, reel.downEnd);
+  }
+  return rampDelay(_landingSpeed, _restSpeed, reel.phase, reel.downEnd, reel.stopPhase);
+}
+
+// Plans the motion of every reel for the whole spin and starts the reel timers. The
+// top speed spin is stretched by up to a turn of the scroll pattern so every reel
+// comes to rest on its first phase, the landing then always looks the same.
+void GameCore::planSpin(unsigned long spinTime, unsigned long now) {
+  _restSpeed = _config.minSpeed;
+  _fullSpeed = _config.topSpeed;
+  _landingSpeed = _config.startSpeed;
+  _spinStart = now;
+  _spinDuration = 0;
+  _tickReel = 0;
+  for (uint8_t i = 0; i < Geometry::reels; i++) {
+    ReelMotion &reel = _motion[i];
+    uint16_t up = rampPhases(_restSpeed, _fullSpeed, _accel[i]);
+    uint16_t down = rampPhases(_fullSpeed, _landingSpeed, _accel[i]);
+    uint16_t cruise = spinTime * scrollSubsteps / _fullSpeed;
+    uint16_t total = up + cruise + down + landingPhases;
+    cruise += (scrollPhaseCount - total % scrollPhaseCount) % scrollPhaseCount;
+    reel.upEnd = up;
+    reel.cruiseEnd = up + cruise;
+    reel.downEnd = reel.cruiseEnd + down;
+    reel.stopPhase = reel.downEnd + landingPhases;
+    reel.cruiseDelay = _fullSpeed / scrollSubsteps;
+
+    // the top speed spin in one go, the ramps phase by phase
+    unsigned long duration = (unsigned long)cruise * reel.cruiseDelay;
+    for (reel.phase = 0; reel.phase < reel.stopPhase; reel.phase++) {
+      if (reel.phase == reel.upEnd) {
+        reel.phase = reel.cruiseEnd;
+      }
+      duration += phaseDelay(reel);
+    }
+    if (duration > _spinDuration) {
+      _spinDuration = duration;
+      _tickReel = i;
+    }
+    reel.phase = 0;
+    _timers.start(REEL_TIMER + i, phaseDelay(reel), now);
+  }
+}
+
+// Skips the rest of SPINUP or SPINNING: the plan of every reel is cut down to a landing
+// at an even pace, reel i at rest (i + 1) / reels of quickStopTime from now
+void GameCore::quickStop(unsigned long now) {
+  unsigned long longest = 0;
+  for (uint8_t i = 0; i < Geometry::reels; i++) {
+    ReelMotion &reel = _motion[i];
+    uint16_t left = landingPhases + (scrollPhaseCount - (reel.phase + landingPhases) % scrollPhaseCount) % scrollPhaseCount;
+    reel.upEnd = 0;
+    reel.stopPhase = reel.phase + left;
+    reel.cruiseEnd = reel.stopPhase;
+    reel.downEnd = reel.stopPhase;
+    reel.cruiseDelay = (unsigned long)_config.quickStopTime * (i + 1) / Geometry::reels / left;
+    _timers.start(REEL_TIMER + i, reel.cruiseDelay, now);
+    if ((unsigned long)reel.cruiseDelay * left > longest) {
+      longest = (unsigned long)reel.cruiseDelay * left;
+      _tickReel = i;
+    }
+  }
+  _spinDuration = now - _spinStart + longest;
+  _state = SPINDOWN;
+}
+
+// Pays the round out once every reel stopped
+void GameCore::finishRound(unsigned long now) {
+  int payout = payoutFor(_wintype);
+  _ledger.won += payout;
+  _ledger.displayLag += payout;
+  _out.events |= GAME_ROUND_OVER;
+  _out.payout = payout;
+  // a short pause only when another round follows
+  bool queued = _autoplayRounds > 0 || _queuedSpins > 0;
+  _timers.start(STAGE_TIMER, queued ? _config.roundPause : _config.waitBeforeIdle, now);
+  _state = WAITING;
+}
+
+void GameCore::nextAnimationFrame(unsigned long now) {
+  for (uint8_t i = 0; i < Geometry::reels; i++) {
+    ReelMotion &reel = _motion[i];
+    // a late step catches up on the planned phases instead of shifting the rest
+    while (reel.phase < reel.stopPhase && _timers.expired(REEL_TIMER + i, now)) {
+      reel.phase++;
+      if (reel.phase < reel.stopPhase) {
+        _timers.advance(REEL_TIMER + i, phaseDelay(reel));
+      } else {
+        _out.events |= GAME_REEL_STOPPED;
+      }
+      // the reel planned to come to rest last paces the ticks
+      if (i == _tickReel && reel.phase % scrollSubsteps == 0) {
+        _out.events |= GAME_REEL_STEP;
+      }
+    }
+  }
+
+  uint8_t frame[Geometry::rows][Geometry::reels];
+  for (uint8_t i = 0; i < Geometry::reels; i++) {
+    // the result comes in from the top, one row per symbol step left, below it the
+    // scrolling pattern goes on
+    uint16_t stepsLeft = (_motion[i].stopPhase - _motion[i].phase + scrollSubsteps - 1) / scrollSubsteps;
+    uint8_t position = _motion[i].phase % scrollPhaseCount;
+    for (uint8_t j = 0; j < Geometry::rows; j++) {
+      if (j + stepsLeft < Geometry::rows) {
+        frame[j][i] = _result[i][j + stepsLeft];
+      } else {
+        frame[j][i] = pgm_read_byte(&scrollPhases[scrollPhase(position, j)]);
+      }
+    }
+  }
+  showReels(frame);
+}
+
+// Shows the next frame of the attract animation, the next animation once it ended
+void GameCore::nextIdleAnimationFrame(unsigned long now) {
+  uint16_t frameTime = _attract.step();
+  if (_attract.finished()) {
+    _currentIdleAnimation = (_currentIdleAnimation + 1) % idleAnimationAmount;
+    _attract.start((const uint8_t *)pgm_read_ptr(&idleAnimations[_currentIdleAnimation]));
+    frameTime = _attract.step();
+  }
+  showReels(_attract.frame);
+  _timers.start(IDLE_FRAME_TIMER, frameTime, now);
+}
+
+// The winning line goes dark every other blinkTime until WAITING is over
+void GameCore::blinkWin(unsigned long now) {
+  bool dark = (_timers.remaining(STAGE_TIMER, now) / _config.blinkTime) % 2 == 0;
+  uint8_t frame[Geometry::rows][Geometry::reels];
+  for (uint8_t i = 0; i < Geometry::rows; i++) {
+    for (uint8_t j = 0; j < Geometry::reels; j++) {
+      frame[i][j] = dark && isOnLine(_wintype, i, j) ? 0b00000000 : _result[j][i];
+    }
+  }
+  showReels(frame);
+}
+
+void GameCore::animateBalanceBlink(unsigned long now) {
+  if (!_timers.expired(BLINK_TIMER, now)) {
+    return;
+  }
+  _timers.start(BLINK_TIMER, balanceBlinkTime, now);
+  _blinkBalance--;
+  _out.balanceOn = !_out.balanceOn;
+}
+
+// Only frames that differ from the last one count as changed
+void GameCore::showReels(const uint8_t frame[Geometry::rows][Geometry::reels]) {
+  if (_reelsValid && memcmp(frame, _out.reels, sizeof(_out.reels)) == 0) {
+    return;
+  }
+  memcpy(_out.reels, frame, sizeof(_out.reels));
+  _reelsValid = true;
+  _out.reelsChanged = true;
+}
+
+void GameCore::showBalance(const uint8_t digits[4]) {
+  memcpy(_out.balance, digits, sizeof(_out.balance));
+  _out.balanceChanged = true;
+}
+
+// Right aligned cents, without leading zeros; four digits is all the display has
+void GameCore::renderBalance() {
+  int32_t value = _ledger.balance() - _ledger.displayLag;
+  bool negative = value < 0;
+  uint32_t digits = negative ? -value : value;
+  if (digits > (negative ? 999 : 9999)) {
+    digits = negative ? 999 : 9999;
+  }
+
+  uint8_t output[4] = {0, 0, 0, 0};
+  int position = 3;
+  do {
+    output[position--] = pgm_read_byte(&balanceDigits[digits % 10]);
+    digits /= 10;
+  } while (digits > 0 && position >= 0);
+  if (negative) {
+    output[position] = TM1637_CHAR_MIN;
+  }
+  showBalance(output);
+}
+
+void GameCore::seed(uint32_t entropy) {
+  _random = entropy % 0x7fffffffUL;
+}
+
+// Mixes the start time of a round into the state instead of replacing it, so rounds
+// that start at the same times after boot still draw from where the last one left off
+void GameCore::mix(unsigned long now) {
+  _random = (_random ^ now) % 0x7fffffffUL;
+}
+
+// random() of avr-libc (Park-Miller minimal standard) and the Arduino wrappers around it
+long GameCore::random(long howbig) {
+  if (howbig == 0) {
+    return 0;
+  }
+  int32_t x = _random;
+  if (x == 0) {
+    x = 123459876L;
+  }
+  int32_t hi = x / 127773L;
+  int32_t lo = x % 127773L;
+  x = 16807L * lo - 2836L * hi;
+  if (x < 0) {
+    x += 0x7fffffffL;
+  }
+  _random = x;
+  return x % howbig;
+}
+
+long GameCore::random(long howsmall, long howbig) {
+  if (howsmall >= howbig) {
+    return howsmall;
+  }
+  return random(howbig - howsmall) + howsmall;
+}
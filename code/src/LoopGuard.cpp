@@ -0,0 +1,107 @@
+#include "LoopGuard.h"
+#include "CycleClock.h"
+#ifdef __AVR__
+#include <avr/wdt.h>
+#endif
+
+LoopGuard loopGuard;
+
+const uint16_t recordMagic = 0x4C47;
+const uint8_t watchdogOff = 0xFF;
+// Watchdog timeouts in ms, the index is the WDTO_ value
+const uint16_t watchdogTimeouts[] PROGMEM = {15, 30, 60, 120, 250, 500, 1000, 2000, 4000, 8000};
+const uint8_t watchdogTimeoutCount = sizeof(watchdogTimeouts) / sizeof(watchdogTimeouts[0]);
+
+#ifdef __AVR__
+
+// The C runtime neither clears nor initialises .noinit, so both survive a reset
+LoopGuardRecord guardRecord __attribute__((section(".noinit")));
+uint8_t resetCause __attribute__((section(".noinit")));
+
+// Runs before the C runtime initialises RAM. After a watchdog reset the watchdog
+// keeps running with its shortest timeout, so it has to be stopped right here.
+// Optiboot clears MCUSR itself and hands a copy over in r2.
+void saveResetCause() __attribute__((naked, used, section(".init3")));
+void saveResetCause() {
+  uint8_t bootloaderFlags;
+  __asm__ __volatile__ ("mov %0, r2" : "=r" (bootloaderFlags));
+  resetCause = MCUSR != 0 ? MCUSR : bootloaderFlags & 0x0F;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+#else
+
+LoopGuardRecord guardRecord;
+uint8_t resetCause = LOOP_GUARD_POWER_ON;
+
+#endif
+
+void LoopGuard::begin() {
+  _previous = guardRecord;
+  _hasPrevious = guardRecord.magic == recordMagic &&
+                 !(resetCause & (LOOP_GUARD_POWER_ON | LOOP_GUARD_BROWN_OUT));
+  guardRecord.magic = recordMagic;
+  guardRecord.state = 0;
+  guardRecord.budget = watchdogOff;
+  guardRecord.maxLoopState = 0;
+  guardRecord.maxLoopCycles = 0;
+  guardRecord.maxInterruptCycles = 0;
+  CycleClock::begin();
+}
+
+uint8_t LoopGuard::resetFlags() const {
+  return resetCause;
+}
+
+void LoopGuard::arm(uint16_t budget) {
+  uint8_t index = 0;
+  while (index < watchdogTimeoutCount - 1 && pgm_read_word(&watchdogTimeouts[index]) < budget) {
+    index++;
+  }
+  if (index == guardRecord.budget) {
+    return;
+  }
+  if (guardRecord.budget == watchdogOff) {
+    // setup() is not a loop iteration
+    _loopStart = CycleClock::now();
+  }
+  guardRecord.budget = index;
+#ifdef __AVR__
+  wdt_enable(index);
+#endif
+}
+
+void LoopGuard::loopStarted(uint8_t state) {
+  uint32_t now = CycleClock::now();
+  if (guardRecord.budget != watchdogOff) {
+    uint32_t cycles = now - _loopStart;
+    if (cycles > guardRecord.maxLoopCycles) {
+      guardRecord.maxLoopCycles = cycles;
+      guardRecord.maxLoopState = guardRecord.state;
+    }
+  }
+  _loopStart = now;
+  guardRecord.state = state;
+#ifdef __AVR__
+  wdt_reset();
+#endif
+}
+
+void LoopGuard::interruptDone(uint32_t start) {
+  uint32_t cycles = CycleClock::now() - start;
+  if (cycles > guardRecord.maxInterruptCycles) {
+    guardRecord.maxInterruptCycles = cycles;
+  }
+}
+
+uint32_t LoopGuard::maxLoopCycles() const {
+  return guardRecord.maxLoopCycles;
+}
+
+uint32_t LoopGuard::maxInterruptCycles() const {
+  noInterrupts();
+  uint32_t cycles = guardRecord.maxInterruptCycles;
+  interrupts();
+  return cycles;
+}
@@ -0,0 +1,88 @@
+#include "MemoryWatch.h"
+
+uint16_t MemoryWatch::_heapHighWater = 0;
+
+#ifdef __AVR__
+
+extern uint8_t __data_start;
+extern uint8_t _end;
+extern uint8_t __heap_start;
+extern char *__brkval;
+
+// Runs before the stack pointer is set up and before .data and .bss are
+// initialised, so it may not call anything or use the stack
+void paintStack() __attribute__((naked, used, section(".init1")));
+void paintStack() {
+  __asm__ __volatile__ ("clr __zero_reg__");
+  uint8_t *p = &_end;
+  while (p <= (uint8_t *)RAMEND) {
+    *p++ = MEMORY_CANARY;
+  }
+}
+
+static uint8_t *heapEnd() {
+  return __brkval != 0 ? (uint8_t *)__brkval : &__heap_start;
+}
+
+void MemoryWatch::sample() {
+  uint16_t heap = heapEnd() - &__heap_start;
+  if (heap > _heapHighWater) {
+    _heapHighWater = heap;
+  }
+}
+
+uint16_t MemoryWatch::staticBytes() {
+  return &_end - &__data_start;
+}
+
+uint16_t MemoryWatch::heapHighWater() {
+  sample();
+  return _heapHighWater;
+}
+
+uint16_t MemoryWatch::stackHighWater() {
+  return (uint8_t *)RAMEND - heapEnd() + 1 - untouched();
+}
+
+uint16_t MemoryWatch::untouched() {
+  // heap allocations overwrite canaries too, start above the heap
+  const uint8_t *p = heapEnd();
+  const uint8_t *top = (const uint8_t *)SP;
+  uint16_t count = 0;
+  while (p < top && *p == MEMORY_CANARY) {
+    p++;
+    count++;
+  }
+  return count;
+}
+
+uint16_t MemoryWatch::freeNow() {
+  return (uint8_t *)SP - heapEnd();
+}
+
+#else
+
+void MemoryWatch::sample() {
+}
+
+uint16_t MemoryWatch::staticBytes() {
+  return 0;
+}
+
+uint16_t MemoryWatch::heapHighWater() {
+  return _heapHighWater;
+}
+
+uint16_t MemoryWatch::stackHighWater() {
+  return 0;
+}
+
+uint16_t MemoryWatch::untouched() {
+  return 0;
+}
+
+uint16_t MemoryWatch::freeNow() {
+  return 0;
+}
+
+#endif
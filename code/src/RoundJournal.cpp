@@ -0,0 +1,127 @@
+#include <EEPROM.h>
+#include <stddef.h>
+#include "RoundJournal.h"
+#include "Crc16.h"
+
+void RoundJournal::begin() {
+  _head = EEPROM_JOURNAL_RECORDS - 1;
+  _size = 0;
+  _sequence = 0;
+
+  JournalRecord record;
+  for (uint8_t slot = 0; slot < EEPROM_JOURNAL_RECORDS; slot++) {
+    read(slot, record);
+    if (!isValid(record)) {
+      continue;
+    }
+    // sequence numbers wrap, so compare them by distance
+    if (_size == 0 || (int16_t)(record.sequence - _sequence) > 0) {
+      _head = slot;
+      _sequence = record.sequence;
+    }
+    _size++;
+  }
+}
+
+bool RoundJournal::pendingRound(JournalRecord &record) const {
+  if (_size == 0) {
+    return false;
+  }
+  read(_head, record);
+  return record.status == JOURNAL_OPEN;
+}
+
+void RoundJournal::openRound(uint8_t outcome, uint16_t stake) {
+  uint8_t slot = (_head + 1) % EEPROM_JOURNAL_RECORDS;
+  int statusAddress = address(slot) + offsetof(JournalRecord, status);
+
+  JournalRecord record;
+  read(slot, record);
+  if (!isValid(record)) {
+    _size++;
+  }
+
+  record.sequence = _sequence + 1;
+  record.stake = stake;
+  record.payout = 0;
+  record.outcome = outcome;
+  record.status = JOURNAL_EMPTY;
+
+  // invalidate the old record first, then commit the new one with its status byte
+  EEPROM.update(statusAddress, JOURNAL_EMPTY);
+  EEPROM.put(address(slot), record);
+  EEPROM.update(statusAddress, JOURNAL_OPEN);
+
+  _head = slot;
+  _sequence = record.sequence;
+}
+
+void RoundJournal::settleRound(uint16_t payout, uint8_t status) {
+  JournalRecord record;
+  if (!pendingRound(record)) {
+    return;
+  }
+  EEPROM.put(address(_head) + offsetof(JournalRecord, payout), payout);
+  EEPROM.update(address(_head) + offsetof(JournalRecord, status), status);
+}
+
+uint8_t RoundJournal::dump(Print &out, uint8_t count) const {
+  JournalRecord record;
+
+  // walk back from the newest record to find where the dump starts
+  if (count > _size) {
+    count = _size;
+  }
+  uint8_t first = _head;
+  uint8_t found = 0;
+  for (uint8_t i = 0; i < EEPROM_JOURNAL_RECORDS && found < count; i++) {
+    first = (_head + EEPROM_JOURNAL_RECORDS - i) % EEPROM_JOURNAL_RECORDS;
+    read(first, record);
+    if (isValid(record)) {
+      found++;
+    }
+  }
+
+  const uint8_t header[4] = {'J', 'R', JOURNAL_VERSION, found};
+  uint16_t crc = crc16Init;
+  for (uint8_t i = 0; i < sizeof(header); i++) {
+    crc = crc16Update(crc, header[i]);
+  }
+  out.write(header, sizeof(header));
+
+  uint8_t sent = 0;
+  for (uint8_t slot = first; sent < found; slot = (slot + 1) % EEPROM_JOURNAL_RECORDS) {
+    read(slot, record);
+    if (!isValid(record)) {
+      continue;
+    }
+    const uint8_t *bytes = (const uint8_t *)&record;
+    for (uint8_t i = 0; i < sizeof(record); i++) {
+      crc = crc16Update(crc, bytes[i]);
+    }
+    out.write(bytes, sizeof(record));
+    sent++;
+  }
+
+  out.write((uint8_t)(crc & 0xFF));
+  out.write((uint8_t)(crc >> 8));
+  return sent;
+}
+
+uint8_t RoundJournal::size() const {
+  return _size;
+}
+
+int RoundJournal::address(uint8_t slot) {
+  return EEPROM_JOURNAL_START + slot * sizeof(JournalRecord);
+}
+
+void RoundJournal::read(uint8_t slot, JournalRecord &record) {
+  EEPROM.get(address(slot), record);
+}
+
+bool RoundJournal::isValid(const JournalRecord &record) {
+  return record.status == JOURNAL_OPEN ||
+         record.status == JOURNAL_SETTLED ||
+         record.status == JOURNAL_RECOVERED;
+}
@@ -0,0 +1,137 @@
+#include "Sound.h"
+#include "Config.h"
+#include "CycleClock.h"
+#include "FastGPIO.h"
+#include "Wiring.h"
+
+Sound sound;
+
+typedef FastPin<soundPin> Speaker;
+
+// Pitches of the notes, 0 is a rest
+enum Pitch {
+  REST,
+  NOTE_C4, NOTE_CS4, NOTE_D4, NOTE_DS4, NOTE_E4, NOTE_F4, NOTE_FS4, NOTE_G4, NOTE_GS4, NOTE_A4, NOTE_AS4, NOTE_B4,
+  NOTE_C5, NOTE_CS5, NOTE_D5, NOTE_DS5, NOTE_E5, NOTE_F5, NOTE_FS5, NOTE_G5, NOTE_GS5, NOTE_A5, NOTE_AS5, NOTE_B5,
+  NOTE_C6, NOTE_CS6, NOTE_D6, NOTE_DS6, NOTE_E6, NOTE_F6, NOTE_FS6, NOTE_G6, NOTE_GS6, NOTE_A6, NOTE_AS6, NOTE_B6,
+  NOTE_C7, NOTE_CS7, NOTE_D7, NOTE_DS7, NOTE_E7, NOTE_F7, NOTE_FS7, NOTE_G7, NOTE_GS7, NOTE_A7, NOTE_AS7, NOTE_B7
+};
+
+// Phase steps of the pitches at 10 kHz: frequency * 65536 / 10000
+const uint16_t pitchSteps[] PROGMEM = {
+  1715, 1817, 1925, 2039, 2160, 2289, 2425, 2569, 2722, 2884, 3055, 3237,
+  3429, 3633, 3849, 4078, 4320, 4577, 4850, 5138, 5443, 5767, 6110, 6473,
+  6858, 7266, 7698, 8156, 8641, 9155, 9699, 10276, 10887, 11534, 12220, 12947,
+  13717, 14532, 15396, 16312, 17282, 18310, 19398, 20552, 21774, 23069, 24440, 25894,
+};
+
+// Sequences: pitch, length in units of 4 ms, a length of 0 ends them
+const uint8_t tickNotes[] PROGMEM = {
+  NOTE_E7, 1,
+  0, 0
+};
+const uint8_t coinNotes[] PROGMEM = {
+  NOTE_B5, 16,
+  NOTE_E6, 50,
+  0, 0
+};
+const uint8_t reelStopNotes[] PROGMEM = {
+  NOTE_G4, 6,
+  NOTE_C4, 8,
+  0, 0
+};
+const uint8_t winNotes[] PROGMEM = {
+  NOTE_C5, 30,
+  NOTE_E5, 30,
+  NOTE_G5, 30,
+  NOTE_C6, 45,
+  REST, 8,
+  NOTE_G5, 15,
+  NOTE_C6, 90,
+  0, 0
+};
+
+const uint8_t *const sequences[SOUND_COUNT] PROGMEM = {
+  tickNotes,
+  coinNotes,
+  reelStopNotes,
+  winNotes,
+};
+
+static_assert(CYCLES_PER_MICROSECOND * 1000000UL / Sound::samplePeriod == 10000,
+              "pitchSteps are made for a 10 kHz sample rate");
+
+#ifdef __AVR__
+
+// Lets the dimmer and the coin capture in right away, see Sound.h
+ISR(TIMER1_COMPB_vect, ISR_NOBLOCK) {
+  sound.sample();
+}
+
+#endif
+
+void Sound::begin() {
+  _note = 0;
+  _phase = 0;
+  _step = 0;
+  _left = 0;
+  _busy = false;
+  _playing = SOUND_TICK;
+#ifdef __AVR__
+  Speaker::low();
+  Speaker::output();
+#endif
+}
+
+void Sound::play(SoundId id) {
+  if (config.sound == 0 || (_busy && id < _playing)) {
+    return;
+  }
+#ifdef __AVR__
+  // only the sound interrupt stops while the sequence changes
+  TIMSK1 &= ~_BV(OCIE1B);
+  _note = (const uint8_t *)pgm_read_ptr(&sequences[id]);
+  _playing = id;
+  _busy = true;
+  nextNote();
+  OCR1B = TCNT1 + samplePeriod;
+  TIFR1 = _BV(OCF1B);
+  TIMSK1 |= _BV(OCIE1B);
+#endif
+}
+
+void Sound::sample() {
+#ifdef __AVR__
+  // from the last match, so a late interrupt does not stretch the notes
+  OCR1B += samplePeriod;
+  uint16_t phase = _phase + _step;
+  _phase = phase;
+  Speaker::write(phase & 0x8000);
+  if (--_left == 0) {
+    nextNote();
+  }
+#endif
+}
+
+// Loads the next note, or ends the sound after the last one
+void Sound::nextNote() {
+  const uint8_t *note = _note;
+  uint8_t length = pgm_read_byte(note + 1);
+  if (length == 0) {
+#ifdef __AVR__
+    TIMSK1 &= ~_BV(OCIE1B);
+    Speaker::low();
+#endif
+    _busy = false;
+    return;
+  }
+  uint8_t pitch = pgm_read_byte(note);
+  if (pitch == REST) {
+    _step = 0;
+    _phase = 0;
+  } else {
+    _step = pgm_read_word(&pitchSteps[pitch - 1]);
+  }
+  _left = length * samplesPerUnit;
+  _note = note + 2;
+}
@@ -0,0 +1,162 @@
+#include "Telemetry.h"
+#include "Crc16.h"
+
+Telemetry telemetry;
+
+void Telemetry::begin(HardwareSerial &port) {
+  _port = &port;
+  _head = 0;
+  _tail = 0;
+  _sequence = 0;
+  _dropped = 0;
+  _enabled = true;
+}
+
+bool Telemetry::send(uint8_t type, const uint8_t *payload, uint8_t length) {
+  uint8_t packet[6 + TELEMETRY_MAX_PAYLOAD + 2];
+  if (!_enabled) {
+    return false;
+  }
+  if (length > TELEMETRY_MAX_PAYLOAD) {
+    length = TELEMETRY_MAX_PAYLOAD;
+  }
+
+  unsigned long now = millis();
+  uint8_t size = 0;
+  packet[size++] = type;
+  packet[size++] = _sequence;
+  for (uint8_t i = 0; i < 4; i++) {
+    packet[size++] = (now >> (8 * i)) & 0xFF;
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    packet[size++] = payload[i];
+  }
+  uint16_t crc = crc16Init;
+  for (uint8_t i = 0; i < size; i++) {
+    crc = crc16Update(crc, packet[i]);
+  }
+  packet[size++] = crc & 0xFF;
+  packet[size++] = crc >> 8;
+
+  // COBS adds one code byte per packet (they stay below 254 bytes) plus the delimiter
+  if (freeSpace() < size + 2) {
+    if (_dropped < 255) {
+      _dropped++;
+    }
+    return false;
+  }
+  _sequence++;
+
+  uint8_t codeIndex = _head;
+  uint8_t code = 1;
+  push(0);
+  for (uint8_t i = 0; i < size; i++) {
+    if (packet[i] == 0) {
+      _queue[codeIndex] = code;
+      codeIndex = _head;
+      code = 1;
+      push(0);
+    } else {
+      push(packet[i]);
+      code++;
+    }
+  }
+  _queue[codeIndex] = code;
+  push(0);
+  return true;
+}
+
+void Telemetry::poll() {
+  int room = _port->availableForWrite();
+  while (room > 0 && _tail != _head) {
+    _port->write(_queue[_tail]);
+    _tail = (_tail + 1) % TELEMETRY_QUEUE_SIZE;
+    room--;
+  }
+}
+
+void Telemetry::flush() {
+  while (_tail != _head) {
+    poll();
+  }
+  _port->flush();
+}
+
+void Telemetry::setEnabled(bool enabled) {
+  _enabled = enabled;
+}
+
+bool Telemetry::isEnabled() const {
+  return _enabled;
+}
+
+void Telemetry::sendBoot(uint8_t reels, uint8_t rows) {
+  const uint8_t payload[3] = {TELEMETRY_VERSION, reels, rows};
+  send(TELEMETRY_BOOT, payload, sizeof(payload));
+}
+
+void Telemetry::sendState(uint8_t state) {
+  send(TELEMETRY_STATE, &state, 1);
+}
+
+void Telemetry::sendOutcome(uint8_t wintype, uint16_t winCells, const unsigned long *accel, uint8_t reels) {
+  uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+  uint8_t size = 0;
+  payload[size++] = wintype;
+  payload[size++] = winCells & 0xFF;
+  payload[size++] = winCells >> 8;
+  for (uint8_t i = 0; i < reels && size + 2 <= TELEMETRY_MAX_PAYLOAD; i++) {
+    uint16_t steps = accel[i] > 0xFFFF ? 0xFFFF : accel[i];
+    payload[size++] = steps & 0xFF;
+    payload[size++] = steps >> 8;
+  }
+  send(TELEMETRY_OUTCOME, payload, size);
+}
+
+void Telemetry::sendCoin(uint16_t value, int32_t balance) {
+  const uint8_t payload[6] = {
+    (uint8_t)(value & 0xFF), (uint8_t)(value >> 8),
+    (uint8_t)(balance & 0xFF), (uint8_t)((uint32_t)balance >> 8),
+    (uint8_t)((uint32_t)balance >> 16), (uint8_t)((uint32_t)balance >> 24)
+  };
+  send(TELEMETRY_COIN, payload, sizeof(payload));
+}
+
+void Telemetry::sendRoundOver(uint16_t payout, int32_t balance) {
+  const uint8_t payload[6] = {
+    (uint8_t)(payout & 0xFF), (uint8_t)(payout >> 8),
+    (uint8_t)(balance & 0xFF), (uint8_t)((uint32_t)balance >> 8),
+    (uint8_t)((uint32_t)balance >> 16), (uint8_t)((uint32_t)balance >> 24)
+  };
+  send(TELEMETRY_ROUND_OVER, payload, sizeof(payload));
+}
+
+void Telemetry::sendProfile(uint16_t loops, uint16_t maxLoopMicros) {
+  const uint8_t payload[5] = {
+    (uint8_t)(loops & 0xFF), (uint8_t)(loops >> 8),
+    (uint8_t)(maxLoopMicros & 0xFF), (uint8_t)(maxLoopMicros >> 8),
+    _dropped
+  };
+  if (send(TELEMETRY_PROFILE, payload, sizeof(payload))) {
+    _dropped = 0;
+  }
+}
+
+void Telemetry::sendReset(uint8_t flags, uint8_t state, uint8_t maxLoopState, uint32_t maxLoopCycles,
+                          uint32_t maxInterruptCycles) {
+  uint8_t payload[11] = {flags, state, maxLoopState};
+  for (uint8_t i = 0; i < 4; i++) {
+    payload[3 + i] = maxLoopCycles >> (8 * i);
+    payload[7 + i] = maxInterruptCycles >> (8 * i);
+  }
+  send(TELEMETRY_RESET, payload, sizeof(payload));
+}
+
+void Telemetry::push(uint8_t value) {
+  _queue[_head] = value;
+  _head = (_head + 1) % TELEMETRY_QUEUE_SIZE;
+}
+
+uint8_t Telemetry::freeSpace() const {
+  return TELEMETRY_QUEUE_SIZE - 1 - (_head + TELEMETRY_QUEUE_SIZE - _tail) % TELEMETRY_QUEUE_SIZE;
+}
@@ -1,191 +1,63 @@
 #include <Arduino.h>
 #include "SevenSegmentTM1637.h"
-
-///////////////////////////////////////
-////             Pins              ////
-///////////////////////////////////////
-
-// Serial data out to shift registers
-const int dataPin = 9;
-// Latch to update the current value of the registers
-const int latchPin = 10;
-// Clock for serial data to shift registers
-const int clockPin = 11;
-
-// Interrupt for buttons
-const int interruptPin = 2;
-// Input to start game
-const int triggerPin = 6;
-// Input to add 50 cents to the balance
-const int fivetyCentPin = 5;
-// Input to add one euro to the balance
-const int oneEuroPin = 4;
-// Input to add two euros to the balance
-const int twoEurosPin = 3;
-
-// 4 block 7-segment display clock
-const int balanceClock = 13;
-// 4 block 7-segment display data
-const int balanceData = 12;
+#include "SevenSegmentTM1637Lite.h"
+#include "TM1637Calibration.h"
+#include "FastGPIO.h"
+#include "ShiftRegisterDimmer.h"
+#include "RoundJournal.h"
+#include "Telemetry.h"
+#include "Config.h"
+#include "Console.h"
+#include "CycleClock.h"
+#include "LoopGuard.h"
+#include "MemoryWatch.h"
+#include "GameCore.h"
+#include "CoinAcceptor.h"
+#include "Sound.h"
+#include "ReelGeometry.h"
+#include "Wiring.h"
+
+// Human readable serial output. Off by default, it shares the line with the
+// binary telemetry and costs milliseconds of TX time per line.
+#define SERIAL_DEBUG false
+
+#if SERIAL_DEBUG
+  #define DEBUG_PRINT(...)    Serial.print(__VA_ARGS__)
+  #define DEBUG_PRINTLN(...)  Serial.println(__VA_ARGS__)
+#else
+  #define DEBUG_PRINT(...)
+  #define DEBUG_PRINTLN(...)
+#endif
 
 ///////////////////////////////////////
 ////          Constants            ////
 ///////////////////////////////////////
 
-SevenSegmentTM1637 display(balanceClock, balanceData);
-
-// Time between frames 1000/50 = 20 fps
-const int frameTime = 500;
-// Time after a spin to wait before resuming idle animation
-const int waitBeforeIdle = 10000;
-// Time to display the spinup animation
-const int spinTime = 5000;
-// minimum ms per frame
-const unsigned long topSpeed = 50;
-const unsigned long minSpeed = 450;
-const unsigned long startSpeed = 390;
-const int minRandomAccell = 30;
-const int maxRandomAccell = 40;
-const int blinkTime = 250;
-
-/*
-Bit order from left to right
-
-   --0--
-  |     |
-  1     2
-  |     |
-   --3--
-  |     |
-  5     4
-  |     |
-   --6--   7
-
-*/
-const int lroffsets[9] = {8,5,0,7,4,1,6,3,2};
-
-const int idleAnimationAmount = 2;
-const int idleAnimationSizes[2] = {8, 10};
-//          [animation][frames][x][y]
-const byte idleAnimations[2][10][3][3] = {
-  {
-    {
-      {0b11111111, 0b00000000, 0b00000000},
-      {0b00000000, 0b00010001, 0b00000000},
-      {0b00000000, 0b00000000, 0b00010001},
-    },
-    {
-      {0b00000000, 0b00000000, 0b00000000},
-      {0b11111111, 0b00010001, 0b00010001},
-      {0b00000000, 0b00000000, 0b00000000},
-    },
-    {
-      {0b00000000, 0b00000000, 0b00010001},
-      {0b00000000, 0b00010001, 0b00000000},
-      {0b11111111, 0b00000000, 0b00000000},
-    },
-    {
-      {0b00000000, 0b00010001, 0b00000000},
-      {0b00000000, 0b00010001, 0b00000000},
-      {0b00000000, 0b11111111, 0b00000000},
-    },
-    {
-      {0b00010001, 0b00000000, 0b00000000},
-      {0b00000000, 0b00010001, 0b00000000},
-      {0b00000000, 0b00000000, 0b11111111},
-    },
-    {
-      {0b00000000, 0b00000000, 0b00000000},
-      {0b00010001, 0b00010001, 0b11111111},
-      {0b00000000, 0b00000000, 0b00000000},
-    },
-    {
-      {0b00000000, 0b00000000, 0b11111111},
-      {0b00000000, 0b00010001, 0b00000000},
-      {0b00010001, 0b00000000, 0b00000000},
-    },
-    {
-      {0b00000000, 0b11111111, 0b00000000},
-      {0b00000000, 0b00010001, 0b00000000},
-      {0b00000000, 0b00010001, 0b00000000},
-    },
-  },
-  {
-    {
-      {0b11000100, 0b10000000, 0b10101000},
-      {0b01000100, 0b00000000, 0b00101000},
-      {0b01000110, 0b00000010, 0b00101010},
-    },
-    {
-      {0b00110010, 0b01111100, 0b01010010},
-      {0b10010010, 0b00000000, 0b10010010},
-      {0b10011000, 0b01111100, 0b10010100},
-    },
-    {
-      {0b00001000, 0b00000010, 0b00000100},
-      {0b00101000, 0b00000000, 0b01000100},
-      {0b00100000, 0b10000000, 0b01000000},
-    },
-    {
-      {0b00000000, 0b00000000, 0b00000000},
-      {0b00000000, 0b11101110, 0b00000000},
-      {0b00000000, 0b00000000, 0b00000000},
-    },
-    {
-      {0b00000000, 0b00000000, 0b00000000},
-      {0b00000000, 0b01111101, 0b00000000},
-      {0b00000000, 0b00000000, 0b00000000},
-    },
-    {
-      {0b00000000, 0b00000000, 0b00000000},
-      {0b00000000, 0b11101110, 0b00000000},
-      {0b00000000, 0b00000000, 0b00000000},
-    },
-    {
-      {0b00001000, 0b00000010, 0b00000100},
-      {0b00101000, 0b00000000, 0b01000100},
-      {0b00100000, 0b10000000, 0b01000000},
-    },
-    {
-      {0b00110010, 0b01111100, 0b01010010},
-      {0b10010010, 0b00000000, 0b10010010},
-      {0b10011000, 0b01111100, 0b10010100},
-    },
-    {
-      {0b11000100, 0b10000000, 0b10101000},
-      {0b01000100, 0b00000000, 0b00101000},
-      {0b01000110, 0b00000010, 0b00101010},
-    },
-  },
-};
+// Driver of the balance display. The lite one has the pins fixed at compile time and
+// leaves out Print and the ASCII table; we only send raw segments either way.
+#ifndef BALANCE_DISPLAY_LITE
+#define BALANCE_DISPLAY_LITE true
+#endif
 
-// numbers in 7-segment form
-const byte numbers[10] = {
-  0b11101110, // 0
-  0b00101000, // 1
-  0b10110110, // 2
-  0b10111010, // 3
-  0b01111000, // 4
-  0b11011010, // 5
-  0b11011110, // 6
-  0b10101000, // 7
-  0b11111110, // 8
-  0b11111010, // 9
-};
-
-const byte winSymbol = 0b10101000;
-const byte loseSymbol = 0b00010000;
+#if BALANCE_DISPLAY_LITE
+TM1637<balanceClock, balanceData> display;
+#else
+SevenSegmentTM1637 display(balanceClock, balanceData);
+#endif
+// Port access resolved at compile time, see FastGPIO.h
+typedef ShiftRegisterChain<dataPin, clockPin, latchPin> Registers;
+// Reel digits with brightness levels, Timer2 modulates /OE (see ShiftRegisterDimmer.h)
+typedef ShiftRegisterDimmer<Registers, outputEnablePin, registerCount> Reels;
+RoundJournal journal;
+Console console;
 
-const byte scrolling[5] = {
-  0b10000000,
-  0b01100000,
-  0b00010000,
-  0b00001100,
-  0b00000010,
-};
+// Timing and feel parameters live in Config.h, they can be tuned over the console
 
+// The rules, credits and reel motion live in GameCore.h, this sketch wires it to the
+// buttons, the coin validator, the displays, the journal and the telemetry
+GameCore game(config);
 
-// characters to display the word HELLO in 7-segment form
+// characters to display the word HELLO in 7-segment form (bit order in GameCore.cpp)
 const byte hello[5] = {
   0b01111100, // H
   0b11010110, // E
@@ -194,401 +66,425 @@ const byte hello[5] = {
   0b11101110, // O
 };
 
-const int segmentOrder[3][3] = {
-  {8, 5, 0},
-  {7, 4, 1},
-  {6, 3, 2}
-};
 
 ///////////////////////////////////////
 ////         State machine         ////
 ///////////////////////////////////////
 
-enum State { OFF, IDLE, START_SPINNING, SPINUP, SPINNING, SPINDOWN, WAITING };
-
-// the current state of the machine
-// this has to be volatile according to the documentation for interrupts
-volatile State currentState = OFF;
-
-enum WinType { HTOP, HMID, HBOT, DTL, DTR, NONE };
+// Longest one loop() iteration may take in each state before the watchdog resets
+// the board, in ms (see LoopGuard.h). OFF waits a second per iteration, IDLE and
+// WAITING leave room for console commands that write the EEPROM.
+const uint16_t loopBudget[] = {2000, 500, 250, 250, 250, 250, 500};
 
 ///////////////////////////////////////
 ////          Variables            ////
 ///////////////////////////////////////
 
-// Amount of money belonging to the human
-// this has to be volatile according to the documentation for interrupts
-volatile int balance = 0;
-
-unsigned long spinEndTime = 0;
-
-unsigned long nextStageTime = 0;
-unsigned long nextUpdateTime = 0;
-int currentIdleAnimation = 0;
-int currentIdleAnimationFrame = 0;
-
-WinType wintype = NONE;
-int deltaBalance = 0;
-int blinkBalance = 0;
-
-int pos[3];
-byte result[3][3];
-unsigned long accel[3];
-unsigned long speed[3];
-
-unsigned long nextUpdate[3];
-unsigned long debounceTime;
+// millis() of the last press the interrupt counted, presses for debounceTime after it
+// are ignored. Only the interrupt reads it, and only when a button goes down, so it
+// is an unsigned difference rather than a timer (see Timers.h): that holds across any
+// gap between two presses. setup() takes seconds, so the first press always counts.
+const unsigned long debounceTime = 1000;
+unsigned long lastPress = 0;
+
+// Presses the interrupt counted, per coin value for the coin buttons. Only the interrupt
+// writes them and each is a single byte, so the loop reads them without turning
+// interrupts off and compares with what it took so far; the counts wrap at 256.
+volatile uint8_t triggerPresses = 0;
+volatile uint8_t buttonCoins[COIN_VALUE_COUNT] = {0, 0, 0};
+uint8_t takenPresses = 0;
+uint8_t takenButtonCoins[COIN_VALUE_COUNT] = {0, 0, 0};
+// Whether the balance display is on, it goes off and on while the balance blinks
+bool isDisplayOn = true;
+// Last state sent as telemetry
+State reportedState = OFF;
+// Loop profiling for the telemetry, reset every profilePeriod
+const unsigned long profilePeriod = 1000;
+unsigned long profileStart = 0;
+unsigned long lastLoopStart = 0;
+unsigned int loopCount = 0;
+unsigned long maxLoopTime = 0;
+// busDelay the display bus was last set up for, 0 means calibrated
+uint16_t appliedBusDelay = 0;
 
 
 ///////////////////////////////////////
 ////       Helper functions        ////
 ///////////////////////////////////////
 
-void handleInterrupt() {
-  if (debounceTime > millis()) {
+// Counts a press of the trigger or of a coin button; coin presses during a round wait
+// for its end like the coins of the validator
+void handleButtons() {
+  unsigned long now = millis();
+  if (now - lastPress < debounceTime) {
     return;
   }
   if (!digitalRead(triggerPin)) {
-    if (currentState == OFF) {
-      Serial.println("ON");
-      display.print("PLAY");
-      currentState = IDLE;
-      debounceTime = millis() + 1000;
-    } else if (currentState == IDLE || currentState == WAITING) {
-      Serial.println("GO");
-      currentState = START_SPINNING;
-      debounceTime = millis() + 1000;
-    }
+    DEBUG_PRINTLN("TRIGGER");
+    triggerPresses++;
+    lastPress = now;
   }
-  if (currentState == IDLE || currentState == WAITING) {
-    if (!digitalRead(fivetyCentPin)) {
-      Serial.println("BUTTON 0.5");
-      balance += 50;
-      deltaBalance += 50;
-      debounceTime = millis() + 1000;
-    }
-    if (!digitalRead(oneEuroPin)) {
-      Serial.println("BUTTON 1");
-      balance += 100;
-      deltaBalance += 100;
-      debounceTime = millis() + 1000;
-    }
-    if (!digitalRead(twoEurosPin)) {
-      Serial.println("BUTTON 2");
-      balance += 200;
-      deltaBalance += 200;
-      debounceTime = millis() + 1000;
-    }
-    Serial.println(balance);
+  if (!digitalRead(fivetyCentPin)) {
+    DEBUG_PRINTLN("BUTTON 0.5");
+    buttonCoins[0]++;
+    lastPress = now;
+  } else if (!digitalRead(oneEuroPin)) {
+    DEBUG_PRINTLN("BUTTON 1");
+    buttonCoins[1]++;
+    lastPress = now;
+  } else if (!digitalRead(twoEurosPin)) {
+    DEBUG_PRINTLN("BUTTON 2");
+    buttonCoins[2]++;
+    lastPress = now;
   }
 }
 
-void printData(byte data[9]) {
-  digitalWrite(latchPin, LOW);
-  for (int i = 0; i < 9; i++) {
-    shiftOut(dataPin, clockPin, LSBFIRST, data[i]);
-  }
-  digitalWrite(latchPin, HIGH);
+void handleInterrupt() {
+  uint32_t start = CycleClock::now();
+  handleButtons();
+  loopGuard.interruptDone(start);
 }
 
 void fillScreen(byte value) {
-  digitalWrite(latchPin, LOW);
-  for (int i = 0; i < 9; i++) {
-    shiftOut(dataPin, clockPin, LSBFIRST, value);
-  }
-  digitalWrite(latchPin, HIGH);
+  Reels::fill(value);
 }
 
-void printHello(){
-  byte output[9];
-  for (int i = 0; i < 5; i++) {
-    output[lroffsets[i]] = hello[i];
-  }
-  for (int i = 5; i < 9; i++) {
-    output[lroffsets[i]] = 0b00000000;
-  }
-  printData(output);
+// Dims the reels while the machine advertises itself, full level while someone plays
+void applyBrightness() {
+  State state = game.state();
+  Reels::setLevel(state == IDLE || state == OFF ? config.idleBrightness : config.reelBrightness);
 }
 
-void fillLoseSymbols(){
-  for (int i = 0; i < 3; i++) {
-    for (int j = 0; j < 3; j++) {
-      result[i][j] = loseSymbol;
-    }
+// HELLO in reading order, left to right and top to bottom
+void printHello(){
+  byte *output = Reels::back();
+  for (int i = 0; i < Geometry::cells; i++) {
+    output[segmentOrder[i / Geometry::reels][i % Geometry::reels]] = i < 5 ? hello[i] : 0b00000000;
   }
+  Reels::publish();
 }
 
-void renderMatrix(byte matrix[3][3]) {
-  byte output[9];
+// matrix is [row][reel], the interrupt picks the frame up with its next refresh
+void renderMatrix(const byte matrix[Geometry::rows][Geometry::reels]) {
+  byte *output = Reels::back();
 
-  for (int i = 0; i < 3; i++) {
-    for (int j = 0; j < 3; j++) {
+  for (int i = 0; i < Geometry::rows; i++) {
+    for (int j = 0; j < Geometry::reels; j++) {
       output[segmentOrder[i][j]] = matrix[i][j];
     }
   }
-  printData(output);
+  Reels::publish();
 }
 
-void renderBalance() {
-  String balanceDisplay = String(balance - deltaBalance);
-  while (balanceDisplay.length() < 4) {
-    balanceDisplay = " " + balanceDisplay;
+// Hands out the next coin button press not taken yet, false if there is none
+bool takeButtonCoin(uint16_t &cents) {
+  for (uint8_t i = 0; i < COIN_VALUE_COUNT; i++) {
+    if (buttonCoins[i] != takenButtonCoins[i]) {
+      takenButtonCoins[i]++;
+      cents = coinValues[i];
+      return true;
+    }
   }
-  display.print(balanceDisplay);
+  return false;
 }
 
-void animateBalanceChange() {
-  deltaBalance += deltaBalance > 0 ? -5 : 5;
-  renderBalance();
-}
+// Moves the game on to now: hands it the presses and one coin, then shows its frames,
+// plays its sounds and writes the journal and the telemetry for what happened
+void stepGame() {
+  GameInputs inputs;
+  uint8_t presses = triggerPresses;
+  inputs.trigger = presses != takenPresses;
+  takenPresses = presses;
+  inputs.triggerDown = !digitalRead(triggerPin);
+  // coins that come in during a spin wait until it is over, one per step
+  uint16_t coin = 0;
+  if (game.acceptsCoins() && !takeButtonCoin(coin)) {
+    coinAcceptor.take(coin);
+  }
+  inputs.coin = coin;
 
-bool isDisplayOn = true;
-void animateBalanceBlink() {
-  if (nextUpdateTime > millis()) {
-    return;
+  const GameOutput &out = game.step(millis(), inputs);
+
+  if (out.events & GAME_COIN) {
+    telemetry.sendCoin(out.coin, game.balance());
   }
-  Serial.print("Blink ");
-  Serial.println(isDisplayOn);
-  nextUpdateTime = millis() + 350;
-  blinkBalance--;
-
-  if (isDisplayOn) {
-    display.off();
-    isDisplayOn = false;
-  } else {
-    display.on();
-    renderBalance();
-    isDisplayOn = true;
+  if (out.events & GAME_ROUND_OPENED) {
+    DEBUG_PRINT("Win: ");
+    DEBUG_PRINTLN(game.outcome());
+    DEBUG_PRINT("Spin: ");
+    DEBUG_PRINTLN(game.spinDuration());
+    telemetry.sendOutcome(game.outcome(), game.winCells(), game.accel(), Geometry::reels);
+    // the outcome is on EEPROM before the first reel moves
+    journal.openRound(game.outcome(), GameCore::spinCost);
+  }
+  if (out.events & GAME_ROUND_OVER) {
+    DEBUG_PRINTLN("Round over!");
+    journal.settleRound(out.payout);
+    telemetry.sendRoundOver(out.payout, game.balance());
   }
-}
 
-void startSpinning() {
-  randomSeed(millis());
-  fillLoseSymbols();
-  long randomOurcome = random(100);
-
-  if (randomOurcome < 25) { // (25%)
-    wintype = NONE;
-    int emptyRow = random(3);
-    for (int j = 0; j < 3; j++) {
-      for (int i = 0; i < 3; i++) {
-        if (j == emptyRow) {
-          break;
-        }
-        result[0][i] = random(2) ? winSymbol : loseSymbol;
-      }
-    }
-  } else if (randomOurcome < 50) { // (25%)
-    if (random(2)) {
-      wintype = DTL;
-      result[0][0] = winSymbol;
-      result[2][2] = winSymbol;
-    } else {
-      wintype = DTR;
-      result[0][2] = winSymbol;
-      result[2][0] = winSymbol;
-    }
-    result[1][1] = winSymbol;
-  } else if (randomOurcome < 75) { // (25%)
-    int height;
-    if(random(2)){
-        height = 0;
-        wintype = HTOP;
+  // one sound per step, the most important; Sound keeps a more important one playing
+  if ((out.events & GAME_ROUND_OVER) && out.payout > 0) {
+    sound.play(SOUND_WIN);
+  } else if (out.events & GAME_REEL_STOPPED) {
+    sound.play(SOUND_REEL_STOP);
+  } else if (out.events & GAME_COIN) {
+    sound.play(SOUND_COIN);
+  } else if (out.events & GAME_REEL_STEP) {
+    sound.play(SOUND_TICK);
+  }
+
+  if (out.reelsChanged) {
+    renderMatrix(out.reels);
+  }
+  if (out.balanceChanged) {
+    display.printRaw(out.balance, 4, 0);
+  }
+  // only the display control byte goes out, the digits stay in the display RAM
+  if (out.balanceOn != isDisplayOn) {
+    if (out.balanceOn) {
+      display.on();
     } else {
-      height = 2;
-      wintype = HBOT;
-    }
-    for (int i = 0; i < 3; i++) {
-      result[i][height] = winSymbol;
-    }
-  } else {
-    wintype = HMID; // (25%)
-    for (int i = 0; i < 3; i++) {
-      result[i][1] = winSymbol;
+      display.off();
     }
+    isDisplayOn = out.balanceOn;
   }
+}
 
-  Serial.print("Win: ");
-  Serial.println(wintype);
-
-  for (int i = 0; i < 3; i++) {
-    accel[i] = random(minRandomAccell, maxRandomAccell);
-    speed[i] = minSpeed;
+#ifdef __AVR__
+// Left behind by the last run, a reset does not clear it (garbage after power on)
+uint32_t seedCarry __attribute__((section(".noinit")));
+#endif
+
+// Seeds the outcome generator once: the lowest bit of 32 readings of the open analog
+// input and what the last run left in RAM. On the host random(), the sim's seed.
+void seedOutcomes() {
+#ifdef __AVR__
+  uint32_t entropy = seedCarry;
+  for (uint8_t i = 0; i < 32; i++) {
+    entropy = (entropy << 1 | entropy >> 31) ^ (analogRead(noisePin) & 1);
+  }
+  entropy ^= micros();
+  seedCarry = entropy * 16807UL + 1;
+#else
+  uint32_t entropy = random(0x7fffffffL);
+#endif
+  game.seed(entropy);
+}
 
-    Serial.print(' ');
-    for (int j = 0; j < 3; j++) {
-      Serial.print(result[j][i] == winSymbol ? 'X' : '0');
-      Serial.print(' ');
-    }
-    Serial.print(" | ");
-    Serial.println(accel[i]);
-    Serial.println("-------");
+// Pays out a round that was interrupted by a reset or power loss
+void resolvePendingRound() {
+  journal.begin();
+  JournalRecord pending;
+  if (!journal.pendingRound(pending)) {
+    return;
   }
-  currentState = SPINUP;
+  int payout = GameCore::payoutFor((WinType)pending.outcome);
+  DEBUG_PRINT("Recovered round ");
+  DEBUG_PRINT(pending.sequence);
+  DEBUG_PRINT(", payout ");
+  DEBUG_PRINTLN(payout);
+  game.payRecovered(payout);
+  journal.settleRound(payout, JOURNAL_RECOVERED);
 }
 
-void spinup() {
-  if(millis() > nextUpdateTime) {
-    for (int i = 0; i < 3; i++) {
-      if (speed[i] > topSpeed) {
-        speed[i] -= accel[i];
-      }
-    }
-    nextUpdateTime = millis() + frameTime;
+// Sets the display bus timing from the config, calibrates it when busDelay is 0
+void applyBusTiming() {
+  appliedBusDelay = config.busDelay;
+  if (appliedBusDelay != 0) {
+    TM1637Bus::halfPeriod = appliedBusDelay;
+    TM1637Bus::resetCounters();
+  } else if (!tm1637Calibrate(display)) {
+    DEBUG_PRINTLN("Display does not acknowledge");
   }
-  if (speed[0] <= topSpeed && speed[1] <= topSpeed && speed[2] <= topSpeed) {
-    spinEndTime = millis() + spinTime;
-    currentState = SPINNING;
+}
+
+// Follows busDelay changes from the console and slows a calibrated bus down when it fails
+void checkBusTiming() {
+  if (config.busDelay != appliedBusDelay) {
+    applyBusTiming();
+  } else if (appliedBusDelay == 0 && tm1637Check(display)) {
+    DEBUG_PRINT("Bus recalibrated: ");
+    DEBUG_PRINTLN(TM1637Bus::halfPeriod);
   }
 }
 
-void spindown() {
-  if(millis() > nextUpdateTime) {
-    for (int i = 0; i < 3; i++) {
-      if (speed[i] < minSpeed) {
-        speed[i] += accel[i];
-      }
+// Prints one parameter, or all of them for an empty name
+void printConfig(const char *name) {
+  char buffer[20];
+  for (uint8_t i = 0; i < config.count(); i++) {
+    config.name(i, buffer, sizeof(buffer));
+    if (name[0] != '\0' && strcmp(name, buffer) != 0) {
+      continue;
     }
-    if (speed[0] >= minSpeed && speed[1] >= minSpeed && speed[2] >= minSpeed) {
-      Serial.println("Round over!");
-      switch (wintype) {
-        case HMID:
-          deltaBalance += 200;
-          balance += 200;
-          break;
-        case HTOP:
-        case HBOT:
-          deltaBalance += 100;
-          balance += 100;
-          break;
-        case DTL:
-        case DTR:
-          deltaBalance += 50;
-          balance += 50;
-        break;
-        case NONE:
-        default:
-          break;
-      }
-      spinEndTime = millis() + waitBeforeIdle;
-      currentState = WAITING;
+    uint16_t value;
+    config.get(buffer, value);
+    Serial.print(buffer);
+    Serial.print('=');
+    Serial.println(value);
+    if (name[0] != '\0') {
+      return;
     }
-    nextUpdateTime = millis() + frameTime;
+  }
+  if (name[0] != '\0') {
+    Serial.println(F("unknown parameter"));
   }
 }
 
-bool lastState = false;
-
-void blinkWin() {
-  bool state = ((spinEndTime - millis()) / blinkTime) % 2 == 0;
-  if(state == lastState){
-    return;
-  }
-  lastState = state;
-  byte data[3][3];
-  for (int i = 0; i < 3; i++) {
-    for (int j = 0; j < 3; j++) {
-      data[i][j] = result[j][i];
+void runCommand() {
+  const char *command = console.argv(0);
+  long value;
+
+  if (console.overflowed()) {
+    Serial.println(F("line too long"));
+  } else if (strcmp_P(command, PSTR("get")) == 0) {
+    printConfig(console.argv(1));
+  } else if (strcmp_P(command, PSTR("set")) == 0) {
+    if (console.argc() == 3 && console.number(2, value) && value >= 0 && value <= 0xFFFF &&
+        config.set(console.argv(1), value)) {
+      printConfig(console.argv(1));
+    } else {
+      Serial.println(F("invalid value"));
     }
-  }
-  if (state) {
-    switch (wintype) {
-      case HTOP:
-        data[0][0] = 0b00000000;
-        data[0][1] = 0b00000000;
-        data[0][2] = 0b00000000;
-        break;
-      case HMID:
-        data[1][0] = 0b00000000;
-        data[1][1] = 0b00000000;
-        data[1][2] = 0b00000000;
-        break;
-      case HBOT:
-        data[2][0] = 0b00000000;
-        data[2][1] = 0b00000000;
-        data[2][2] = 0b00000000;
-        break;
-      case DTL:
-        data[0][0] = 0b00000000;
-        data[1][1] = 0b00000000;
-        data[2][2] = 0b00000000;
-        break;
-      case DTR:
-        data[0][2] = 0b00000000;
-        data[1][1] = 0b00000000;
-        data[2][0] = 0b00000000;
-        break;
-      case NONE:
-      default:
-        break;
+  } else if (strcmp_P(command, PSTR("save")) == 0) {
+    config.save();
+    Serial.println(F("saved"));
+  } else if (strcmp_P(command, PSTR("load")) == 0) {
+    Serial.println(config.load() ? F("loaded") : F("nothing saved"));
+  } else if (strcmp_P(command, PSTR("defaults")) == 0) {
+    config.reset();
+    Serial.println(F("defaults"));
+  } else if (strcmp_P(command, PSTR("dump")) == 0) {
+    // the dump blocks for a while, so never during a round
+    if (game.state() != OFF && game.state() != IDLE && game.state() != WAITING) {
+      Serial.println(F("busy"));
+    } else if (console.argc() > 1 && console.number(1, value) && value > 0) {
+      journal.dump(Serial, value > EEPROM_JOURNAL_RECORDS ? EEPROM_JOURNAL_RECORDS : value);
+    } else {
+      journal.dump(Serial);
+    }
+  } else if (strcmp_P(command, PSTR("bus")) == 0) {
+    if (strcmp_P(console.argv(1), PSTR("calibrate")) == 0) {
+      applyBusTiming();
     }
+    Serial.print(F("halfPeriod="));
+    Serial.print(TM1637Bus::halfPeriod);
+    Serial.print(config.busDelay != 0 ? F("us fixed") : F("us calibrated"));
+    Serial.print(F(", failures="));
+    Serial.print(TM1637Bus::failures);
+    Serial.print('/');
+    Serial.println(TM1637Bus::transfers);
+  } else if (strcmp_P(command, PSTR("mem")) == 0) {
+    Serial.print(F("static="));
+    Serial.print(MemoryWatch::staticBytes());
+    Serial.print(F(" heap="));
+    Serial.print(MemoryWatch::heapHighWater());
+    Serial.print(F(" stack="));
+    Serial.print(MemoryWatch::stackHighWater());
+    Serial.print(F(" untouched="));
+    Serial.print(MemoryWatch::untouched());
+    Serial.print(F(" free="));
+    Serial.println(MemoryWatch::freeNow());
+  } else if (strcmp_P(command, PSTR("coins")) == 0) {
+    Serial.print(F("dropped="));
+    Serial.print(coinAcceptor.dropped());
+    Serial.print(F(" rejected="));
+    Serial.print(coinAcceptor.rejected());
+    const CreditLedger &ledger = game.ledger();
+    Serial.print(F(" cashIn="));
+    Serial.print(ledger.cashIn);
+    Serial.print(F(" bet="));
+    Serial.print(ledger.bet);
+    Serial.print(F(" won="));
+    Serial.print(ledger.won);
+    Serial.print(F(" balance="));
+    Serial.println(ledger.balance());
+  } else if (strcmp_P(command, PSTR("telemetry")) == 0) {
+    telemetry.setEnabled(strcmp_P(console.argv(1), PSTR("off")) != 0);
+    Serial.println(telemetry.isEnabled() ? F("telemetry on") : F("telemetry off"));
+  } else {
+    Serial.println(F("get [name] | set name value | save | load | defaults | dump [n] | bus [calibrate] | mem | coins | telemetry on|off"));
   }
-  renderMatrix(data);
 }
 
-
-void nextIdleAnimationFrame() {
-  if (currentIdleAnimationFrame >= idleAnimationSizes[currentIdleAnimation]) {
-    currentIdleAnimation = (currentIdleAnimation + 1) % idleAnimationAmount;
-    currentIdleAnimationFrame = 0;
-  }
-
-  byte matrix[3][3];
-  for (int x = 0; x < 3; x++) {
-    for (int y = 0; y < 3; y++) {
-      matrix[x][y] = idleAnimations[currentIdleAnimation][currentIdleAnimationFrame][x][y];
-    }
+// Handles operator commands on the serial port without waiting for input
+void handleSerial() {
+  if (!console.poll()) {
+    return;
   }
-  renderMatrix(matrix);
-
-  currentIdleAnimationFrame++;
+  // replies bypass the queue, so let the packets in it go first
+  telemetry.flush();
+  runCommand();
+  // a zero byte ends the reply like a packet, so telemetry decoders resynchronise
+  Serial.write((uint8_t)0);
 }
 
-void nextAnimationFrame() {
-  for (int i = 0; i < 3; i++) {
-    if (nextUpdate[i] < millis()) {
-      pos[i] = (pos[i] + 1) % 5;
-      nextUpdate[i] = millis() + speed[i];
-    }
+// Reports what changed since the last loop, the interrupt itself never sends
+void reportTelemetry() {
+  if (game.state() != reportedState) {
+    reportedState = game.state();
+    telemetry.sendState(reportedState);
   }
 
-  byte matrix[3][3];
-  for (int i = 0; i < 3; i++) {
-    // Serial.print(speed[i]);
-    // Serial.print(' ');
-
-    if (speed[i] > startSpeed) {
-      for (int j = 0; j < 3; j++) {
-        matrix[i][j] = result[j][i];
-      }
-    } else {
-      matrix[0][i] = scrolling[(pos[i] - 1) % 5];
-      matrix[1][i] = scrolling[pos[i]];
-      matrix[2][i] = scrolling[(pos[i] + 1) % 5];
-    }
+  unsigned long now = micros();
+  unsigned long loopTime = now - lastLoopStart;
+  lastLoopStart = now;
+  loopCount++;
+  if (loopTime > maxLoopTime) {
+    maxLoopTime = loopTime;
+  }
+  if (millis() - profileStart >= profilePeriod) {
+    telemetry.sendProfile(loopCount, maxLoopTime > 0xFFFF ? 0xFFFF : maxLoopTime);
+    profileStart = millis();
+    loopCount = 0;
+    maxLoopTime = 0;
   }
-  // Serial.println();
-  renderMatrix(matrix);
+  telemetry.poll();
 }
 
+void reportReset() {
+  const LoopGuardRecord &previous = loopGuard.previous();
+  if (loopGuard.hasPrevious()) {
+    telemetry.sendReset(loopGuard.resetFlags(), previous.state, previous.maxLoopState,
+                        previous.maxLoopCycles, previous.maxInterruptCycles);
+  } else {
+    telemetry.sendReset(loopGuard.resetFlags(), 0xFF, 0xFF, 0, 0);
+  }
+}
 
 ///////////////////////////////////////
 ////          Main loop            ////
 ///////////////////////////////////////
 
+#if SHIFT_REGISTER_DIMMER_TIMER2
+ISR(TIMER2_COMPA_vect) {
+  Reels::tick();
+}
+#endif
+
 void setup() {
-  pinMode(dataPin, OUTPUT);
-  pinMode(clockPin, OUTPUT);
-  pinMode(latchPin, OUTPUT);
+  loopGuard.begin();
+  Reels::begin();
   pinMode(interruptPin, INPUT_PULLUP);
   pinMode(triggerPin, INPUT_PULLUP);
   pinMode(fivetyCentPin, INPUT_PULLUP);
   pinMode(oneEuroPin, INPUT_PULLUP);
   pinMode(twoEurosPin, INPUT_PULLUP);
-
-  Serial.begin(9600);
-  Serial.print("Booting...");
+  coinAcceptor.begin();
+  sound.begin();
+  seedOutcomes();
+
+  Serial.begin(TELEMETRY_BAUD);
+  telemetry.begin(Serial);
+  telemetry.sendBoot(Geometry::reels, Geometry::rows);
+  reportReset();
+  console.begin(Serial);
+  config.reset();
+  config.load();
+  DEBUG_PRINT("Booting...");
+  resolvePendingRound();
   display.begin();
+  applyBusTiming();
   display.off();
   display.setBacklight(100);
   // for (int i = 0; i < 8; i++) {
@@ -600,8 +496,13 @@ void setup() {
   //   delay(1000);
   // }
   // delay(1000000);
+  // segment test, faded in so the supply does not see all segments switch on at once
+  Reels::setLevel(0);
   fillScreen(0b11111111);
-  delay(500);
+  for (uint8_t level = 1; level <= config.reelBrightness; level++) {
+    Reels::setLevel(level);
+    delay(500 / Reels::maxLevel);
+  }
   fillScreen(0b00000000);
   delay(500);
   printHello();
@@ -610,71 +511,24 @@ void setup() {
   attachInterrupt(digitalPinToInterrupt(interruptPin), handleInterrupt, FALLING);
   delay(100);
 
-  Serial.println("Done!");
+  DEBUG_PRINTLN("Done!");
+  profileStart = millis();
+  lastLoopStart = micros();
+  loopGuard.arm(loopBudget[game.state()]);
 }
 
 void loop() {
-  if (deltaBalance != 0) {
-    animateBalanceChange();
-  }
-  if (blinkBalance > 0) {
-    animateBalanceBlink();
-  }
-  // Serial.println(currentState);
-  switch (currentState) {
-  case OFF:
-    Serial.println("Clear");
-    digitalWrite(latchPin, LOW);
-    for (int i = 0; i < 9; i++) {
-      shiftOut(dataPin, clockPin, LSBFIRST, 0b00000000);
-    }
-    digitalWrite(latchPin, HIGH);
+  loopGuard.loopStarted(game.state());
+  loopGuard.arm(loopBudget[game.state()]);
+  MemoryWatch::sample();
+  coinAcceptor.poll();
+  reportTelemetry();
+  handleSerial();
+  checkBusTiming();
+  applyBrightness();
+  stepGame();
+  if (game.state() == OFF) {
+    // nothing to show until the trigger switches the machine on
     delay(1000);
-    break;
-  case IDLE:
-    if (nextUpdateTime < millis()) {
-      Serial.println("IDLE");
-      nextUpdateTime = millis() + 500;
-      nextIdleAnimationFrame();
-    }
-    break;
-  case START_SPINNING:
-    Serial.print("Start: ");
-    Serial.print(balance);
-    if (balance >= 100) {
-      balance -= 100;
-      deltaBalance -= 100;
-      startSpinning();
-    } else {
-      blinkBalance = 6;
-      if (millis() > spinEndTime) {
-        currentState = IDLE;
-      } else {
-        currentState = WAITING;
-      }
-    }
-    break;
-  case SPINUP:
-    spinup();
-    nextAnimationFrame();
-    break;
-  case SPINNING:
-    if (millis() > spinEndTime) {
-        currentState = SPINDOWN;
-    }
-    nextAnimationFrame();
-    break;
-  case SPINDOWN:
-    spindown();
-    nextAnimationFrame();
-    break;
-  case WAITING:
-    // nextAnimationFrame();
-    blinkWin();
-    // do not play an animation
-    if (millis() > spinEndTime) {
-      currentState = IDLE;
-    }
-    break;
   }
 }
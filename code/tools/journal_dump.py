@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Fetch and decode the round journal of the slot machine.
+
+Sends the dump command over the serial port (or reads a captured dump from a file)
+and prints one line per round, oldest first.
+
+  journal_dump.py --port /dev/ttyUSB0
+  journal_dump.py --file dump.bin --csv
+
+Frame layout (see include/RoundJournal.h):
+  'J' 'R' version count  record[count]  crc16 (little endian)
+  record = <HHHBB  sequence, stake, payout, outcome, status
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+JOURNAL_VERSION = 1
+DUMP_COMMAND = b"dump\n"
+RECORD = struct.Struct("<HHHBB")
+
+OUTCOMES = ["HTOP", "HMID", "HBOT", "DTL", "DTR", "NONE"]
+STATUSES = {0x5A: "open", 0xA5: "settled", 0xC3: "recovered"}
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def find_frame(data):
+    """Returns (records, rest) for the first valid frame in data, or (None, data)."""
+    start = data.find(b"JR")
+    while start >= 0:
+        if len(data) < start + 4:
+            return None, data[start:]
+        version, count = data[start + 2], data[start + 3]
+        end = start + 4 + count * RECORD.size + 2
+        if len(data) < end:
+            return None, data[start:]
+        body = data[start:end - 2]
+        (crc,) = struct.unpack_from("<H", data, end - 2)
+        if version == JOURNAL_VERSION and crc16(body) == crc:
+            records = [RECORD.unpack_from(body, 4 + i * RECORD.size) for i in range(count)]
+            return records, data[end:]
+        start = data.find(b"JR", start + 1)
+    return None, data[-1:]
+
+
+def read_serial(port, baud, timeout):
+    import serial  # pyserial, only needed when talking to the machine
+
+    with serial.Serial(port, baud, timeout=0.1) as link:
+        link.reset_input_buffer()
+        link.write(DUMP_COMMAND)
+        data = b""
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            data += link.read(512)
+            records, _ = find_frame(data)
+            if records is not None:
+                return records
+    raise SystemExit("no journal frame received within %.1f s" % timeout)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial device of the machine")
+    source.add_argument("--file", help="captured dump, '-' for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=5.0)
+    parser.add_argument("--csv", action="store_true", help="print comma separated values")
+    args = parser.parse_args()
+
+    if args.port:
+        records = read_serial(args.port, args.baud, args.timeout)
+    else:
+        stream = sys.stdin.buffer if args.file == "-" else open(args.file, "rb")
+        records, _ = find_frame(stream.read())
+        if records is None:
+            raise SystemExit("no valid journal frame in %s" % args.file)
+
+    if args.csv:
+        print("sequence,outcome,stake,payout,status")
+    for sequence, stake, payout, outcome, status in records:
+        name = OUTCOMES[outcome] if outcome < len(OUTCOMES) else str(outcome)
+        state = STATUSES.get(status, hex(status))
+        if args.csv:
+            print("%d,%s,%d,%d,%s" % (sequence, name, stake, payout, state))
+        else:
+            print("#%-5d %-4s stake %6.2f  payout %6.2f  %s"
+                  % (sequence, name, stake / 100.0, payout / 100.0, state))
+
+
+if __name__ == "__main__":
+    main()
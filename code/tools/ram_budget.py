@@ -0,0 +1,189 @@
+"""PlatformIO post-build check of the SRAM budget (extra_scripts = post:tools/ram_budget.py).
+
+Adds the static data of the firmware (.data, .bss and .noinit from avr-size) to the
+worst case stack derived from the disassembly and fails the build if that exceeds
+the budget:
+
+  custom_ram_budget = 2048    ; bytes of SRAM the firmware may use
+
+The stack figure comes from avr-objdump -d of the linked ELF, after LTO and inlining:
+  - every function's frame is what its prologue pushes and allocates (push, rcall .+0,
+    sbiw/subi on the frame pointer), plus what it pushes for a call's arguments
+  - a call adds the 2 byte return address and the deepest path of its target
+  - main starts below the return address of the C runtime's call, every interrupt
+    vector below the address it interrupted. A vector that enables interrupts first
+    (ISR_NOBLOCK) can have any other on top, so those add up, of the others only the
+    deepest counts
+  - an indirect call (icall, the interrupt handlers of attachInterrupt(), virtual
+    functions) may go to any function the code never calls directly, the deepest of
+    those is taken
+Recursion has no bound, the build fails if it finds any. `mem` on the board shows the
+stack actually used, which should stay below the figure printed here.
+"""
+
+import re
+import subprocess
+
+Import("env")  # noqa: F821 (provided by PlatformIO)
+
+STATIC_SECTIONS = (".data", ".bss", ".noinit")
+RETURN_ADDRESS = 2    # bytes a call pushes on the ATmega328
+
+FUNCTION = re.compile(r"^[0-9a-f]+ <([^>]+)>:$")
+INSTRUCTION = re.compile(r"^\s*[0-9a-f]+:\s+(?:[0-9a-f]{2} )+\s*(\S+)\s*([^;]*)(?:;\s*(.*))?$")
+TARGET = re.compile(r"<([^>+]+)(\+0x[0-9a-f]+)?>")
+# the start code of avr-libc and the vector table, not functions with a frame of their own
+STARTUP = ("__vectors", "__ctors_end", "__init", "__do_copy_data", "__do_clear_bss",
+           "__do_global_ctors", "__bad_interrupt", "_exit", "exit", "__stop_program")
+
+
+class Function(object):
+    def __init__(self, name):
+        self.name = name
+        self.frame = 0
+        self.calls = []         # (target, bytes pushed for the call's arguments)
+        self.indirect = []      # bytes pushed for the arguments of each indirect call
+        self.enables_interrupts = False
+
+
+def frame_size(mnemonic, operands, pending):
+    """Bytes a prologue instruction allocates; pending keeps the low byte of subi r28."""
+    if mnemonic == "push":
+        return 1
+    if mnemonic == "rcall" and operands.startswith(".+0"):
+        return 2
+    if mnemonic == "sbiw" and operands.startswith("r28"):
+        return int(operands.split(",")[1], 0)
+    if mnemonic == "subi" and operands.startswith("r28"):
+        pending["low"] = int(operands.split(",")[1], 0)
+    if mnemonic == "sbci" and operands.startswith("r29") and "low" in pending:
+        size = int(operands.split(",")[1], 0) << 8 | pending.pop("low")
+        # subtracting a negative number gives a frame back (epilogue)
+        return size if size < 0x8000 else 0
+    return 0
+
+
+def is_prologue(mnemonic, operands):
+    return (mnemonic in ("push", "in", "out", "cli", "sei", "sbiw", "subi", "sbci") or
+            (mnemonic == "rcall" and operands.startswith(".+0")) or
+            (mnemonic == "eor" and operands.replace(" ", "") == "r1,r1"))
+
+
+def parse_disassembly(text):
+    functions = {}
+    current = None
+    in_prologue = False
+    pending = {}
+    pushed = 0
+    for line in text.splitlines():
+        match = FUNCTION.match(line)
+        if match:
+            current = functions.setdefault(match.group(1), Function(match.group(1)))
+            in_prologue = True
+            pending = {}
+            pushed = 0
+            continue
+        match = INSTRUCTION.match(line)
+        if current is None or not match:
+            continue
+        mnemonic, operands, comment = match.group(1), match.group(2).strip(), match.group(3) or ""
+        if in_prologue and mnemonic == "sei" and current.frame == 0:
+            current.enables_interrupts = True
+        if in_prologue and is_prologue(mnemonic, operands):
+            current.frame += frame_size(mnemonic, operands, pending)
+            continue
+        in_prologue = False
+        # arguments pushed for a call, popped (or given back with the frame) after it
+        if mnemonic == "push" or (mnemonic == "rcall" and operands.startswith(".+0")):
+            pushed += 1 if mnemonic == "push" else 2
+        elif mnemonic == "pop":
+            pushed = max(0, pushed - 1)
+        elif mnemonic in ("icall", "eicall"):
+            current.indirect.append(pushed)
+        elif mnemonic in ("call", "rcall", "jmp", "rjmp"):
+            target = TARGET.search(comment)
+            # a jump into another function is a tail call, into the same one a branch
+            if target and not target.group(2) and target.group(1) != current.name:
+                current.calls.append((target.group(1), pushed))
+    return functions
+
+
+def stack_usage(functions):
+    """Worst case stack of main and the interrupts, and the recursive functions found."""
+    called = set(target for function in functions.values() for target, _ in function.calls)
+    vectors = [name for name in functions if re.match(r"__vector_\d+$", name)]
+    indirect_targets = [name for name in functions
+                        if name not in called and name not in vectors and
+                        name != "main" and name not in STARTUP]
+    depths = {}
+    recursive = set()
+
+    def depth(name, active):
+        if name in depths:
+            return depths[name]
+        function = functions.get(name)
+        if function is None:
+            return 0
+        if name in active:
+            recursive.add(name)
+            return 0
+        active.add(name)
+        deepest = 0
+        for target, pushed in function.calls:
+            deepest = max(deepest, pushed + RETURN_ADDRESS + depth(target, active))
+        if function.indirect:
+            # an indirect call back into an active function is taken as no deeper
+            reach = max([depth(target, active) for target in indirect_targets
+                         if target not in active] or [0])
+            deepest = max(deepest, max(function.indirect) + RETURN_ADDRESS + reach)
+        active.discard(name)
+        depths[name] = function.frame + deepest
+        return depths[name]
+
+    main = RETURN_ADDRESS + depth("main", set())
+    nested = 0
+    blocking = 0
+    for vector in vectors:
+        used = RETURN_ADDRESS + depth(vector, set())
+        if functions[vector].enables_interrupts:
+            nested += used
+        else:
+            blocking = max(blocking, used)
+    return main, nested + blocking, sorted(recursive)
+
+
+def section_sizes(elf):
+    output = subprocess.check_output([env.subst("$SIZETOOL"), "-A", elf], universal_newlines=True)
+    sizes = {}
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0].startswith(".") and fields[1].isdigit():
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def disassemble(elf):
+    objdump = env.subst("$SIZETOOL").replace("size", "objdump")
+    return subprocess.check_output([objdump, "-d", elf], universal_newlines=True)
+
+
+def check_ram(source, target, env):
+    budget = int(env.GetProjectOption("custom_ram_budget", "2048"))
+    elf = target[0].get_abspath()
+    sizes = section_sizes(elf)
+    static = sum(sizes.get(name, 0) for name in STATIC_SECTIONS)
+    main, interrupts, recursive = stack_usage(parse_disassembly(disassemble(elf)))
+    stack = main + interrupts
+    used = static + stack
+    print("SRAM: %d static (%s) + %d stack (main %d, interrupts %d) = %d of %d bytes, %d spare" % (
+        static, ", ".join("%s %d" % (name, sizes.get(name, 0)) for name in STATIC_SECTIONS),
+        stack, main, interrupts, used, budget, budget - used))
+    if recursive:
+        print("SRAM: no stack bound, recursion through %s" % ", ".join(recursive))
+        env.Exit(1)
+    if used > budget:
+        print("SRAM budget exceeded by %d bytes" % (used - budget))
+        env.Exit(1)
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", check_ram)  # noqa: F821
@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+"""Decode the binary telemetry of the slot machine into JSON lines or CSV.
+
+Reads a serial port, a pty of the native build, a capture file or stdin:
+
+  telemetry_decode.py --port /dev/ttyUSB0
+  telemetry_decode.py --file /dev/pts/7 --format csv
+  .pio/build/native/program --duration 30000 | telemetry_decode.py --file - --min-frames 10
+
+Packets are COBS encoded and end with a 0x00 byte (see include/Telemetry.h):
+  type  sequence  millis[4]  payload  crc16[2]
+Frames that fail the CRC are counted and skipped, console replies (plain text
+terminated by 0x00) come out as "text" records.
+"""
+
+import argparse
+import csv
+import json
+import struct
+import sys
+
+STATES = ["OFF", "IDLE", "START_SPINNING", "SPINUP", "SPINNING", "SPINDOWN", "WAITING"]
+OUTCOMES = ["HTOP", "HMID", "HBOT", "DTL", "DTR", "NONE"]
+
+# reels and rows of the machine, from its boot packet
+geometry = {"reels": 3, "rows": 3}
+
+
+def name(names, index):
+    return names[index] if index < len(names) else index
+
+
+def decode_boot(payload):
+    if len(payload) >= 3:
+        geometry.update(reels=payload[1], rows=payload[2])
+    return {"version": payload[0], "reels": geometry["reels"], "rows": geometry["rows"]}
+
+
+def decode_state(payload):
+    return {"state": name(STATES, payload[0])}
+
+
+def decode_outcome(payload):
+    wintype, cells = struct.unpack_from("<BH", payload)
+    width = geometry["reels"] * geometry["rows"]
+    return {"outcome": name(OUTCOMES, wintype), "cells": "{:0{}b}".format(cells, width),
+            "accel": [a for (a,) in struct.iter_unpack("<H", payload[3:])]}
+
+
+def decode_coin(payload):
+    value, balance = struct.unpack("<Hi", payload)
+    return {"value": value, "balance": balance}
+
+
+def decode_round_over(payload):
+    payout, balance = struct.unpack("<Hi", payload)
+    return {"payout": payout, "balance": balance}
+
+
+def decode_profile(payload):
+    loops, max_loop_us, dropped = struct.unpack("<HHB", payload)
+    return {"loops": loops, "max_loop_us": max_loop_us, "dropped": dropped}
+
+
+RESET_FLAGS = ["power_on", "reset_button", "brown_out", "watchdog"]
+CYCLES_PER_US = 16
+
+
+def decode_reset(payload):
+    flags, state, max_loop_state, max_loop_cycles, max_interrupt_cycles = struct.unpack("<BBBII", payload)
+    known = state != 0xFF
+    return {"flags": "+".join(flag for bit, flag in enumerate(RESET_FLAGS) if flags & (1 << bit)) or "none",
+            "state": name(STATES, state) if known else None,
+            "max_loop_state": name(STATES, max_loop_state) if known else None,
+            "max_loop_us": max_loop_cycles // CYCLES_PER_US,
+            "max_interrupt_us": max_interrupt_cycles / CYCLES_PER_US}
+
+
+PACKETS = {
+    0x01: ("boot", decode_boot),
+    0x02: ("state", decode_state),
+    0x03: ("outcome", decode_outcome),
+    0x04: ("coin", decode_coin),
+    0x05: ("round_over", decode_round_over),
+    0x06: ("profile", decode_profile),
+    0x07: ("reset", decode_reset),
+}
+
+CSV_FIELDS = ["millis", "sequence", "type", "version", "reels", "rows", "state", "outcome", "cells", "accel",
+              "value", "payout", "balance", "loops", "max_loop_us", "dropped", "flags", "max_loop_state",
+              "max_interrupt_us", "text"]
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame):
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def is_text(frame):
+    """Console replies are plain text lines between the packets."""
+    return all(byte in (9, 10, 13) or 32 <= byte < 127 for byte in frame)
+
+
+def decode_packet(frame):
+    """Returns the packet as a dict, or None if the frame is damaged."""
+    packet = cobs_decode(frame)
+    if packet is None or len(packet) < 8:
+        return None
+    (crc,) = struct.unpack_from("<H", packet, len(packet) - 2)
+    if crc16(packet[:-2]) != crc:
+        return None
+    kind, sequence, millis = struct.unpack_from("<BBI", packet)
+    payload = packet[6:-2]
+    record = {"millis": millis, "sequence": sequence}
+    if kind in PACKETS:
+        record["type"], decoder = PACKETS[kind]
+        try:
+            record.update(decoder(payload))
+        except (struct.error, IndexError):
+            return None
+    else:
+        record["type"] = "unknown_%02x" % kind
+        record["payload"] = payload.hex()
+    return record
+
+
+class Decoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.good = 0
+        self.bad = 0
+
+    def feed(self, data):
+        """Yields every packet completed by data."""
+        self.buffer += data
+        while True:
+            end = self.buffer.find(b"\x00")
+            if end < 0:
+                return
+            frame = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            if not frame:
+                continue
+            record = decode_packet(frame)
+            if record is None and is_text(frame):
+                yield {"type": "text", "text": frame.decode("ascii").strip()}
+            elif record is None:
+                self.bad += 1
+            else:
+                self.good += 1
+                yield record
+
+
+def chunks(args):
+    if args.port:
+        import serial  # pyserial, only needed when talking to the machine
+
+        with serial.Serial(args.port, args.baud, timeout=0.1) as link:
+            while True:
+                yield link.read(256)
+    else:
+        stream = sys.stdin.buffer if args.file == "-" else open(args.file, "rb", buffering=0)
+        while True:
+            data = stream.read(256) if args.file != "-" else stream.read1(256)
+            if not data:
+                return
+            yield data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial device of the machine")
+    source.add_argument("--file", help="capture file or pty, '-' for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--format", choices=["jsonl", "csv"], default="jsonl")
+    parser.add_argument("--min-frames", type=int, default=0,
+                        help="exit with an error if fewer valid packets were decoded")
+    args = parser.parse_args()
+
+    writer = None
+    if args.format == "csv":
+        writer = csv.DictWriter(sys.stdout, fieldnames=CSV_FIELDS, extrasaction="ignore")
+        writer.writeheader()
+
+    decoder = Decoder()
+    try:
+        for data in chunks(args):
+            for record in decoder.feed(data):
+                if writer:
+                    writer.writerow(record)
+                else:
+                    print(json.dumps(record))
+                sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+
+    print("%d packets, %d damaged frames" % (decoder.good, decoder.bad), file=sys.stderr)
+    if decoder.good < args.min_frames:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()